@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nogo.h"
+#include "pool.h"
+#include "analyze.h"
+
+/*
+ * Analyses every saved game in a directory tree. Each file is mapped into
+ * memory and its strings found with a single flood fill over the board as
+ * saved, rather than loading it with load_game(), which rebuilds the strings
+ * a stone at a time. Files are analysed across a pool of threads, and their
+ * results written in order of their names once all are done.
+ */
+
+/* the analysis of a saved game */
+struct Analysis {
+    char* filename;
+    int status; //0, or the error found reading the file (see error_message())
+    short height; //the number of vertical squares on the board
+    short width; //the number of horizontal squares on the board
+    char nextPlayer; //the player to move
+    int stones; //the number of stones on the board
+    int stringCount; //the number of strings, counting lone stones
+    int* liberties; //the number of liberties of each string, in row order
+    int ataris[2]; //the number of strings of 'O' and 'X' in atari
+    bool lost; //true if the player to move can't stop the next move losing
+};
+
+/* every saved game found in a directory tree */
+struct AnalysisRun {
+    struct Analysis* files;
+    int count; //the number of files
+    int capacity; //the number of files there is room for
+};
+
+/* scratch space for analysing a board, see find_strings() */
+struct Board {
+    const char* squares; //the rows of the saved board, each ending in '\n'
+    short height;
+    short width;
+    int* strings; //the string of each stone, by square
+    int* seen; //the last string each empty square was counted as a liberty of
+    int* stack; //the stones of the string being filled
+    int* libertySquares; //the first two liberties found of each string
+    unsigned char* ataris; //for each square, bit c set if it is the last
+                           //liberty of a string of colour c
+};
+
+/* the offsets of the 4 squares next to a square */
+static const int rowSteps[4] = {-1, 0, 1, 0};
+static const int columnSteps[4] = {0, 1, 0, -1};
+
+/*
+ * adds every regular file in a directory tree to the run
+ */
+static void find_files(struct AnalysisRun* run, const char* path) {
+    DIR* directory = opendir(path);
+    if (!directory) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(directory))) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        char* name = malloc(strlen(path) + strlen(entry->d_name) + 2);
+        sprintf(name, "%s/%s", path, entry->d_name);
+
+        //avoid a stat() for each file where the directory gives its type
+        unsigned char type = entry->d_type;
+        struct stat info;
+        if (type == DT_UNKNOWN && !lstat(name, &info)) {
+            type = S_ISDIR(info.st_mode) ? DT_DIR :
+                    S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+
+        if (type == DT_DIR) {
+            find_files(run, name);
+        } else if (type == DT_REG) {
+            if (run->count == run->capacity) {
+                run->capacity = run->capacity ? run->capacity * 2 : 256;
+                run->files = realloc(run->files,
+                        sizeof(struct Analysis) * run->capacity);
+            }
+            struct Analysis* file = &run->files[run->count++];
+            memset(file, 0, sizeof(struct Analysis));
+            file->filename = name;
+            continue;
+        }
+        free(name);
+    }
+    closedir(directory);
+}
+
+/*
+ * orders files by name
+ */
+static int compare_files(const void* first, const void* second) {
+    return strcmp(((const struct Analysis*) first)->filename,
+            ((const struct Analysis*) second)->filename);
+}
+
+/*
+ * returns the colour of a square, 0 for 'O', 1 for 'X', 2 for empty, or 3
+ * off the board
+ */
+static int colour_at(struct Board* board, int row, int column) {
+    if (row < 0 || row >= board->height || column < 0 ||
+            column >= board->width) {
+        return 3;
+    }
+    switch (board->squares[row * (board->width + 1) + column]) {
+        case 'O':
+            return 0;
+        case 'X':
+            return 1;
+    }
+    return 2;
+}
+
+/*
+ * Finds every string on the board with a flood fill, recording the number of
+ * liberties of each, and marking the last liberty of each string in atari.
+ *
+ * returns the number of strings found
+ */
+static int find_strings(struct Board* board, struct Analysis* analysis,
+        bool dead[2]) {
+    int width = board->width;
+    int squares = board->height * width;
+    int count = 0;
+    memset(board->seen, -1, sizeof(int) * squares);
+    memset(board->strings, -1, sizeof(int) * squares);
+    memset(board->ataris, 0, squares);
+
+    for (int square = 0; square < squares; square++) {
+        int colour = colour_at(board, square / width, square % width);
+        if (colour > 1 || board->strings[square] >= 0) {
+            continue;
+        }
+
+        int liberties = 0, size = 0;
+        int* libertySquares = &board->libertySquares[count * 2];
+        board->strings[square] = count;
+        board->stack[size++] = square;
+        for (int next = 0; next < size; next++) {
+            int row = board->stack[next] / width;
+            int column = board->stack[next] % width;
+            for (int direction = 0; direction < 4; direction++) {
+                int adjacentRow = row + rowSteps[direction];
+                int adjacentColumn = column + columnSteps[direction];
+                int adjacent = adjacentRow * width + adjacentColumn;
+                int adjacentColour = colour_at(board, adjacentRow,
+                        adjacentColumn);
+                if (adjacentColour == colour &&
+                        board->strings[adjacent] < 0) {
+                    board->strings[adjacent] = count;
+                    board->stack[size++] = adjacent;
+                } else if (adjacentColour == 2 &&
+                        board->seen[adjacent] != count) {
+                    board->seen[adjacent] = count;
+                    if (liberties < 2) {
+                        libertySquares[liberties] = adjacent;
+                    }
+                    liberties++;
+                }
+            }
+        }
+
+        analysis->liberties[count] = liberties;
+        analysis->stones += size;
+        if (!liberties) {
+            dead[colour] = true;
+        } else if (liberties == 1) {
+            analysis->ataris[colour]++;
+            board->ataris[libertySquares[0]] |= 1 << colour;
+        }
+        count++;
+    }
+    return count;
+}
+
+/*
+ * returns a bit for each colour next to a square (see colour_at())
+ */
+static int adjacent_colours(struct Board* board, int row, int column) {
+    int colours = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        colours |= 1 << colour_at(board, row + rowSteps[direction],
+                column + columnSteps[direction]);
+    }
+    return colours;
+}
+
+/*
+ * Returns true iff a player placing a stone on an empty square wins, by the
+ * engine's rules: a move next to an opposing stone wins if any opposing
+ * string has no liberties, whether or not the move took its last one.
+ */
+static bool move_wins(struct Board* board, bool dead[2], int row, int column,
+        int colour) {
+    int opponent = !colour;
+    return (adjacent_colours(board, row, column) & (1 << opponent)) &&
+            (dead[opponent] || (board->ataris[row * board->width + column] &
+            (1 << opponent)));
+}
+
+/*
+ * returns the number of liberties of the string a player's stone on an
+ * empty square would be part of, as 0, 1 or 2 for two or more
+ */
+static int liberties_after(struct Board* board, struct Analysis* analysis,
+        int row, int column, int colour) {
+    int square = row * board->width + column;
+    int found[2];
+    int count = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        int adjacentRow = row + rowSteps[direction];
+        int adjacentColumn = column + columnSteps[direction];
+        int adjacent = adjacentRow * board->width + adjacentColumn;
+        int adjacentColour = colour_at(board, adjacentRow, adjacentColumn);
+        const int* liberties = &adjacent;
+        int libertyCount = 0;
+        if (adjacentColour == 2) {
+            libertyCount = 1;
+        } else if (adjacentColour == colour) {
+            int string = board->strings[adjacent];
+            if (analysis->liberties[string] > 2) {
+                return 2; //only one of them can be taken by the stone
+            }
+            liberties = &board->libertySquares[string * 2];
+            libertyCount = analysis->liberties[string];
+        }
+
+        for (int i = 0; i < libertyCount; i++) {
+            if (liberties[i] != square && (!count ||
+                    found[0] != liberties[i])) {
+                found[count++] = liberties[i];
+                if (count == 2) {
+                    return 2;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+/*
+ * Works out whether the player to move has already lost: whether every move
+ * either loses at once, or leaves the opponent a winning move. A move next
+ * to an opposing stone which doesn't win loses if any of the mover's strings
+ * has no liberties.
+ */
+static bool is_lost(struct Board* board, struct Analysis* analysis,
+        bool dead[2]) {
+    int mover = (analysis->nextPlayer == 'X');
+    int opponent = !mover;
+
+    //the opponent's winning moves, and the empty squares next to the
+    //mover's stones, which the opponent wins on if a mover's string dies
+    int threats = 0, frontier = 0, emptySquares = 0;
+    for (int row = 0; row < board->height; row++) {
+        for (int column = 0; column < board->width; column++) {
+            if (colour_at(board, row, column) == 2) {
+                emptySquares++;
+                threats += move_wins(board, dead, row, column, opponent);
+                frontier += (adjacent_colours(board, row, column) >> mover)
+                        & 1;
+            }
+        }
+    }
+    if (!emptySquares) {
+        return false; //the game is a draw
+    }
+
+    for (int row = 0; row < board->height; row++) {
+        for (int column = 0; column < board->width; column++) {
+            if (colour_at(board, row, column) != 2) {
+                continue;
+            } else if (move_wins(board, dead, row, column, mover)) {
+                return false;
+            }
+            int colours = adjacent_colours(board, row, column);
+            int liberties = liberties_after(board, analysis, row, column,
+                    mover);
+            if ((colours & (1 << opponent)) && (dead[mover] || !liberties)) {
+                continue; //the move loses at once
+            }
+
+            //other winning moves of the opponent can't be stopped from here
+            if (threats > move_wins(board, dead, row, column, opponent)) {
+                continue;
+            } else if (dead[mover] || !liberties) {
+                //the opponent wins next to any of the mover's stones
+                if (frontier > ((colours >> mover) & 1) || (colours & 4)) {
+                    continue;
+                }
+            } else if (liberties == 1) {
+                continue; //the opponent can take the new string's liberty
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Checks the rows of a saved board, which must each be width squares
+ * followed by a new line, as load_file() requires
+ *
+ * returns true iff the board is valid
+ */
+static bool check_rows(const char* squares, size_t size, short height,
+        short width) {
+    if (size < (size_t) height * (width + 1)) {
+        return false;
+    }
+    for (int row = 0; row < height; row++) {
+        const char* line = squares + row * (width + 1);
+        for (int column = 0; column < width; column++) {
+            if (line[column] != 'X' && line[column] != 'O' &&
+                    line[column] != '.') {
+                return false;
+            }
+        }
+        if (line[width] != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * analyses a saved game mapped into memory
+ *
+ * returns 0 on success, or 5 if its contents are invalid (see error_message())
+ */
+static int analyze_save(struct Analysis* analysis, const char* contents,
+        size_t size) {
+    //the first line is checked by the same parser as load_file() uses
+    const char* lineEnd = memchr(contents, '\n', size < 70 ? size : 70);
+    if (!lineEnd) {
+        return 5;
+    }
+    char args[70];
+    memcpy(args, contents, lineEnd - contents);
+    args[lineEnd - contents] = '\0';
+    struct GameState game;
+    memset(&game, 0, sizeof(struct GameState));
+    if (parse_first_line(&game, args)) {
+        return 5;
+    }
+    analysis->height = game.height;
+    analysis->width = game.width;
+    analysis->nextPlayer = game.nextPlayer;
+
+    struct Board board = {lineEnd + 1, game.height, game.width};
+    if (!check_rows(board.squares, size - (board.squares - contents),
+            board.height, board.width)) {
+        return 5;
+    }
+
+    int squares = board.height * board.width;
+    board.strings = malloc(sizeof(int) * squares);
+    board.seen = malloc(sizeof(int) * squares);
+    board.stack = malloc(sizeof(int) * squares);
+    board.libertySquares = malloc(sizeof(int) * squares * 2);
+    board.ataris = malloc(squares);
+    analysis->liberties = malloc(sizeof(int) * squares);
+
+    bool dead[2] = {false, false};
+    analysis->stringCount = find_strings(&board, analysis, dead);
+    analysis->lost = is_lost(&board, analysis, dead);
+
+    free(board.strings);
+    free(board.seen);
+    free(board.stack);
+    free(board.libertySquares);
+    free(board.ataris);
+    return 0;
+}
+
+/*
+ * maps one saved game of a run into memory and analyses it
+ */
+static void analyze_file(void* arg, int job) {
+    struct Analysis* analysis = &((struct AnalysisRun*) arg)->files[job];
+    int file = open(analysis->filename, O_RDONLY);
+    struct stat info;
+    if (file < 0 || fstat(file, &info)) {
+        analysis->status = 4;
+    } else if (!info.st_size) {
+        analysis->status = 5;
+    } else {
+        void* contents = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE,
+                file, 0);
+        if (contents == MAP_FAILED) {
+            analysis->status = 4;
+        } else {
+            analysis->status = analyze_save(analysis, contents,
+                    info.st_size);
+            munmap(contents, info.st_size);
+        }
+    }
+    if (file >= 0) {
+        close(file);
+    }
+}
+
+/*
+ * prints a string as a field of CSV, quoting it if needed
+ */
+static void print_csv_string(FILE* output, const char* string) {
+    if (!strpbrk(string, ",\"\n")) {
+        fputs(string, output);
+        return;
+    }
+    fputc('"', output);
+    for (; *string; string++) {
+        if (*string == '"') {
+            fputc('"', output);
+        }
+        fputc(*string, output);
+    }
+    fputc('"', output);
+}
+
+/*
+ * prints the analysis of a saved game as a line of CSV, with the liberties
+ * of its strings separated by spaces
+ */
+static void print_csv(FILE* output, struct Analysis* analysis) {
+    print_csv_string(output, analysis->filename);
+    if (analysis->status) {
+        fprintf(output, ",%s,,,,,,,,,\n", error_message(analysis->status));
+        return;
+    }
+    fprintf(output, ",ok,%d,%d,%c,%d,%d,", analysis->height,
+            analysis->width, analysis->nextPlayer, analysis->stones,
+            analysis->stringCount);
+    for (int i = 0; i < analysis->stringCount; i++) {
+        fprintf(output, i ? " %d" : "%d", analysis->liberties[i]);
+    }
+    fprintf(output, ",%d,%d,%s\n", analysis->ataris[0], analysis->ataris[1],
+            analysis->lost ? "true" : "false");
+}
+
+/*
+ * prints the analysis of a saved game as a single line of JSON
+ */
+static void print_json(FILE* output, struct Analysis* analysis) {
+    fprintf(output, "{\"file\":");
+    print_json_string(output, analysis->filename);
+    if (analysis->status) {
+        fprintf(output, ",\"status\":\"error\",\"error\":");
+        print_json_string(output, error_message(analysis->status));
+        fprintf(output, "}\n");
+        return;
+    }
+    fprintf(output, ",\"status\":\"ok\",\"height\":%d,\"width\":%d,"
+            "\"to_move\":\"%c\",\"stones\":%d,\"strings\":%d,"
+            "\"liberties\":[", analysis->height, analysis->width,
+            analysis->nextPlayer, analysis->stones, analysis->stringCount);
+    for (int i = 0; i < analysis->stringCount; i++) {
+        fprintf(output, i ? ",%d" : "%d", analysis->liberties[i]);
+    }
+    fprintf(output, "],\"ataris\":{\"O\":%d,\"X\":%d},\"lost\":%s}\n",
+            analysis->ataris[0], analysis->ataris[1],
+            analysis->lost ? "true" : "false");
+}
+
+/*
+ * Runs the analysis for the arguments after --analyze, in the form
+ *     [-j threads] [-f csv|json] directory
+ *
+ * returns the exit status of nogo
+ */
+int analyze_main(int argc, char** argv) {
+    int threads = default_thread_count();
+    bool json = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "j:f:")) != -1) {
+        switch (option) {
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'f':
+                json = !strcmp(optarg, "json");
+                if (!json && strcmp(optarg, "csv")) {
+                    threads = 0;
+                }
+                break;
+            default:
+                threads = 0;
+        }
+    }
+    if (optind != argc - 1 || threads < 1) {
+        fprintf(stderr, "Usage: nogo --analyze [-j threads] [-f csv|json] "
+                "directory\n");
+        return 1;
+    }
+
+    struct stat info;
+    if (stat(argv[optind], &info) || !S_ISDIR(info.st_mode)) {
+        fprintf(stderr, "%s\n", error_message(4));
+        return 4;
+    }
+    struct AnalysisRun run = {NULL, 0, 0};
+    find_files(&run, argv[optind]);
+    if (run.count) {
+        qsort(run.files, run.count, sizeof(struct Analysis), compare_files);
+    }
+
+    run_jobs(run.count, threads, analyze_file, &run);
+
+    if (!json) {
+        printf("file,status,height,width,to_move,stones,strings,liberties,"
+                "ataris_o,ataris_x,lost\n");
+    }
+    for (int i = 0; i < run.count; i++) {
+        if (json) {
+            print_json(stdout, &run.files[i]);
+        } else {
+            print_csv(stdout, &run.files[i]);
+        }
+        free(run.files[i].filename);
+        free(run.files[i].liberties);
+    }
+    free(run.files);
+    return 0;
+}
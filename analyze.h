@@ -0,0 +1 @@
+int analyze_main(int argc, char** argv);
@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include "nogo.h"
+#include "stats.h"
+
+/* the offsets of the squares adjacent to a square */
+static const short adjacentRows[4] = {0, 0, 1, -1};
+static const short adjacentColumns[4] = {1, -1, 0, 0};
+
+/*
+ * empty the sets of strings in atari, for a new board
+ */
+void init_ataris(struct GameState* game) {
+    for (int i = 0; i < 2; i++) {
+        game->ataris[i].strings = NULL;
+        game->ataris[i].count = 0;
+        game->ataris[i].capacity = 0;
+        game->ataris[i].deadCount = 0;
+    }
+    game->floodStack = NULL;
+    game->floodCapacity = 0;
+}
+
+/*
+ * returns the set of strings in atari belonging to the given stone value
+ */
+struct AtariSet* get_atari_set(struct GameState* game, char stone) {
+    return &game->ataris[stone == 'X'];
+}
+
+/*
+ * returns the strings in atari belonging to the given stone value, and
+ * stores the number of them in count
+ */
+struct Atari* get_ataris(struct GameState* game, char stone, int* count) {
+    struct AtariSet* set = get_atari_set(game, stone);
+    *count = set->count;
+    return set->strings;
+}
+
+/*
+ * returns true iff placing the given stone value on a square would take the
+ * last liberty of an opposing string
+ */
+bool captures_string(struct GameState* game, short row, short column,
+        char stone) {
+    struct AtariSet* set = get_atari_set(game, stone == 'X' ? 'O' : 'X');
+    for (int i = 0; i < set->count; i++) {
+        if (set->strings[i].liberty.row == row &&
+                set->strings[i].liberty.column == column) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * adds a string of the given stone value to its atari set, growing it if 
+ * necessary, and counts it against the square of its liberty. Liberties in
+ * unallocated tiles aren't counted until the tile is allocated.
+ */
+static void add_atari(struct GameState* game, char stone, short row,
+        short column, struct Point liberty) {
+    struct AtariSet* set = get_atari_set(game, stone);
+    if (set->count == set->capacity) {
+        set->capacity = set->capacity ? set->capacity * 2 : 8;
+        set->strings = realloc(set->strings, 
+                sizeof(struct Atari) * set->capacity);
+        STAT_COUNT(STAT_ALLOCATIONS, 1);
+    }
+    set->strings[set->count].stone.row = row;
+    set->strings[set->count].stone.column = column;
+    set->strings[set->count].liberty = liberty;
+    set->count++;
+
+    struct Tile* tile = get_tile(game, liberty.row, liberty.column, false);
+    if (tile) {
+        tile->atariLiberties[stone == 'X'][liberty.row & TILE_MASK]
+                [liberty.column & TILE_MASK]++;
+    }
+}
+
+/*
+ * counts the strings in atari whose liberties are in a newly allocated tile,
+ * which add_atari() couldn't count against it
+ */
+void init_atari_liberties(struct GameState* game, struct Tile* tile,
+        short row, short column) {
+    for (int i = 0; i < 2; i++) {
+        struct AtariSet* set = &game->ataris[i];
+        for (int j = 0; j < set->count; j++) {
+            struct Point* liberty = &set->strings[j].liberty;
+            if ((liberty->row & ~TILE_MASK) == (row & ~TILE_MASK) &&
+                    (liberty->column & ~TILE_MASK) == (column & ~TILE_MASK)) {
+                tile->atariLiberties[i][liberty->row & TILE_MASK]
+                        [liberty->column & TILE_MASK]++;
+            }
+        }
+    }
+}
+
+/*
+ * Flood fill the string containing the given stone, counting its liberties.
+ * Stops as soon as a second liberty is found, so returns 0, 1, or 2 for two
+ * or more. The first liberty found is stored in liberty.
+ */
+int string_liberties(struct GameState* game, short row, short column,
+        struct Point* liberty) {
+    char stone = get_stone(game, row, column);
+    int liberties = 0;
+    int size = 0; //the number of stones found in the string
+    struct Point* stack;
+
+    //the tile of the given stone is always allocated, so mark it visited
+    struct Tile* tile = get_tile(game, row, column, false);
+    tile->visited[row & TILE_MASK] |= 1 << (column & TILE_MASK);
+    if (game->floodCapacity == 0) {
+        game->floodCapacity = 64;
+        game->floodStack = malloc(sizeof(struct Point) * game->floodCapacity);
+        STAT_COUNT(STAT_ALLOCATIONS, 1);
+    }
+    stack = game->floodStack;
+    stack[size].row = row;
+    stack[size++].column = column;
+
+    for (int next = 0; next < size && liberties < 2; next++) {
+        for (int i = 0; i < 4; i++) {
+            short adjacentRow = stack[next].row + adjacentRows[i];
+            short adjacentColumn = stack[next].column + adjacentColumns[i];
+            char adjacent = get_stone(game, adjacentRow, adjacentColumn);
+
+            if (adjacent == '.') {
+                if (liberties == 0) {
+                    liberty->row = adjacentRow;
+                    liberty->column = adjacentColumn;
+                    liberties = 1;
+                } else if (liberty->row != adjacentRow || 
+                        liberty->column != adjacentColumn) {
+                    liberties = 2;
+                }
+                continue;
+            } else if (adjacent != stone) {
+                continue;
+            }
+
+            //add unvisited stones of the same string to the stack
+            tile = get_tile(game, adjacentRow, adjacentColumn, false);
+            unsigned short bit = 1 << (adjacentColumn & TILE_MASK);
+            if (tile->visited[adjacentRow & TILE_MASK] & bit) {
+                continue;
+            }
+            tile->visited[adjacentRow & TILE_MASK] |= bit;
+            if (size == game->floodCapacity) {
+                game->floodCapacity *= 2;
+                game->floodStack = realloc(game->floodStack, 
+                        sizeof(struct Point) * game->floodCapacity);
+                STAT_COUNT(STAT_ALLOCATIONS, 1);
+                stack = game->floodStack;
+            }
+            stack[size].row = adjacentRow;
+            stack[size++].column = adjacentColumn;
+        }
+    }
+
+    STAT_COUNT(STAT_CELLS_SCANNED, size);
+
+    //clear the visited flags for the next search
+    for (int i = 0; i < size; i++) {
+        get_tile(game, stack[i].row, stack[i].column, false)->
+                visited[stack[i].row & TILE_MASK] = 0;
+    }
+    return liberties;
+}
+
+/*
+ * Update the atari sets for a stone which has just been placed.
+ *
+ * Stones are never removed, so a string's liberties can only change when a
+ * stone is placed next to it. Only the strings adjacent to the new stone 
+ * need to be checked, and any string in atari there has lost its last 
+ * liberty.
+ */
+void update_ataris(struct GameState* game, short row, short column) {
+    char stone = get_stone(game, row, column);
+    char opponent = (stone == 'X') ? 'O' : 'X';
+    struct Point liberty;
+
+    //strings whose last liberty was this square have either been captured,
+    //or joined to the new stone's string
+    for (int i = 0; i < 2; i++) {
+        struct AtariSet* set = &game->ataris[i];
+        for (int j = 0; j < set->count; ) {
+            if (set->strings[j].liberty.row != row ||
+                    set->strings[j].liberty.column != column) {
+                j++;
+                continue;
+            }
+            if (set != get_atari_set(game, stone)) {
+                set->deadCount++;
+            }
+            set->strings[j] = set->strings[--set->count];
+        }
+    }
+    struct Tile* tile = get_tile(game, row, column, false);
+    for (int i = 0; i < 2; i++) {
+        tile->atariLiberties[i][row & TILE_MASK][column & TILE_MASK] = 0;
+    }
+
+    //adjacent opposing strings have lost a liberty, check each string once
+    int checkedIds[4];
+    int checkedCount = 0;
+    for (int i = 0; i < 4; i++) {
+        short adjacentRow = row + adjacentRows[i];
+        short adjacentColumn = column + adjacentColumns[i];
+        if (get_stone(game, adjacentRow, adjacentColumn) != opponent) {
+            continue;
+        }
+
+        int id = get_string_id(game, adjacentRow, adjacentColumn);
+        bool checked = false;
+        for (int j = 0; j < checkedCount; j++) {
+            checked |= (checkedIds[j] == id);
+        }
+        if (checked) {
+            continue;
+        } else if (id) {
+            checkedIds[checkedCount++] = id; //stones with ID 0 are alone
+        }
+
+        //strings left with no liberties were already in atari here
+        if (string_liberties(game, adjacentRow, adjacentColumn, 
+                &liberty) == 1) {
+            add_atari(game, opponent, adjacentRow, adjacentColumn, liberty);
+        }
+    }
+
+    //the new stone's string, including any strings it has joined
+    switch (string_liberties(game, row, column, &liberty)) {
+        case 0:
+            get_atari_set(game, stone)->deadCount++;
+            break;
+        case 1:
+            add_atari(game, stone, row, column, liberty);
+    }
+}
+
+/*
+ * Rebuilds the atari sets from the board, for stones placed before the game
+ * started, whose strings aren't checked as they are placed. The string IDs
+ * of every stone must already be known, so each string is only added once.
+ */
+void find_ataris(struct GameState* game) {
+    for (int i = 0; i < 2; i++) {
+        struct AtariSet* set = &game->ataris[i];
+        for (int j = 0; j < set->count; j++) {
+            struct Point* liberty = &set->strings[j].liberty;
+            struct Tile* tile = get_tile(game, liberty->row, liberty->column,
+                    false);
+            if (tile) {
+                tile->atariLiberties[i][liberty->row & TILE_MASK]
+                        [liberty->column & TILE_MASK] = 0;
+            }
+        }
+        set->count = 0;
+        set->deadCount = 0;
+    }
+
+    bool* checked = calloc(game->stringIdCount + 1, sizeof(bool));
+    STAT_COUNT(STAT_ALLOCATIONS, 1);
+    struct BoardCursor cursor;
+    struct Point liberty;
+    start_scan(&cursor);
+    while (next_stone(game, &cursor)) {
+        int id = get_string_id(game, cursor.row, cursor.column);
+        if (checked[id]) {
+            continue;
+        }
+        checked[id] = (id != 0); //stones with ID 0 are alone
+
+        char stone = get_stone(game, cursor.row, cursor.column);
+        switch (string_liberties(game, cursor.row, cursor.column, &liberty)) {
+            case 0:
+                get_atari_set(game, stone)->deadCount++;
+                break;
+            case 1:
+                add_atari(game, stone, cursor.row, cursor.column, liberty);
+        }
+    }
+    free(checked);
+}
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nogo.h"
+#include "pool.h"
+
+/* the status of a game whose manifest line couldn't be understood */
+#define INVALID_LINE 100
+
+/* the status of a game given a board size but no seed */
+#define MISSING_SEED 101
+
+/* a game listed in a batch manifest, and its result once played */
+struct BatchGame {
+    int line; //the line of the manifest the game was listed on
+    char p1type; //player 1: [c]omputer, or [r]andom or [p]attern moves
+    char p2type; //player 2: [c]omputer, or [r]andom or [p]attern moves
+    int height; //the height of the board
+    int width; //the width of the board
+    char* filename; //the saved game to start from, or NULL for a new game
+    unsigned long long seed; //the seed for the moves of random players
+
+    int status; //0, or the error found while starting the game
+    char winner; //the player who won, or '\0' if the board filled up
+    int moves; //the number of stones placed during the game
+};
+
+/* every game listed in a batch manifest */
+struct Batch {
+    struct BatchGame* games;
+    int count; //the number of games
+    int capacity; //the number of games there is room for
+};
+
+/*
+ * returns the message for a game's error status
+ */
+const char* batch_error_message(int status) {
+    if (status == INVALID_LINE) {
+        return "Invalid manifest line";
+    } else if (status == MISSING_SEED) {
+        return "Missing seed after board size";
+    }
+    return error_message(status);
+}
+
+/*
+ * Parses a line of the manifest, in the form
+ *     p1type p2type height width seed
+ * or
+ *     p1type p2type filename seed
+ *
+ * A number in place of the filename is a board size missing its seed, as
+ * nogo itself would take it, so a file named as a number needs a path,
+ * such as ./9.
+ *
+ * returns 0 on success, or the error status of the game
+ */
+int parse_manifest_line(struct BatchGame* game, char* line) {
+    char* savePtr;
+    char* args[5];
+    int argCount = 0;
+    char* validIntCheck; //to see if strtol returns valid numbers
+
+    for (char* arg = strtok_r(line, " \t\n", &savePtr); arg;
+            arg = strtok_r(NULL, " \t\n", &savePtr)) {
+        if (argCount == 5) {
+            return INVALID_LINE;
+        }
+        args[argCount++] = arg;
+    }
+    if (argCount != 4 && argCount != 5) {
+        return INVALID_LINE;
+    }
+
+    game->seed = strtoull(args[argCount - 1], &validIntCheck, 10);
+    if (*validIntCheck) {
+        return INVALID_LINE;
+    }
+
+    //batch games have no humans to play them
+    game->p1type = *args[0];
+    game->p2type = *args[1];
+    if (strlen(args[0]) > 1 || strlen(args[1]) > 1 ||
+            !strchr("crp", game->p1type) || !strchr("crp", game->p2type)) {
+        return 2;
+    }
+
+    if (argCount == 4) {
+        strtol(args[2], &validIntCheck, 10);
+        if (!*validIntCheck) {
+            game->seed = 0; //the last number was the width
+            return MISSING_SEED;
+        }
+        game->filename = strdup(args[2]);
+        return 0;
+    }
+    game->height = strtol(args[2], &validIntCheck, 10);
+    if (*validIntCheck) {
+        return 3;
+    }
+    game->width = strtol(args[3], &validIntCheck, 10);
+    if (*validIntCheck || !in_size_bounds(game->height, game->width)) {
+        return 3;
+    }
+    return 0;
+}
+
+/*
+ * reads every game from a manifest, skipping blank lines and # comments
+ */
+void read_manifest(struct Batch* batch, FILE* manifest) {
+    char* line = NULL;
+    size_t lineSize = 0;
+    int lineNumber = 0;
+
+    while (getline(&line, &lineSize, manifest) != -1) {
+        lineNumber++;
+        char* start = line + strspn(line, " \t");
+        if (*start == '\n' || *start == '\0' || *start == '#') {
+            continue;
+        }
+
+        if (batch->count == batch->capacity) {
+            batch->capacity = batch->capacity ? batch->capacity * 2 : 64;
+            batch->games = realloc(batch->games,
+                    sizeof(struct BatchGame) * batch->capacity);
+        }
+        struct BatchGame* game = &batch->games[batch->count++];
+        memset(game, 0, sizeof(struct BatchGame));
+        game->line = lineNumber;
+        game->status = parse_manifest_line(game, start);
+    }
+    free(line);
+}
+
+/*
+ * Plays one game of a batch to the end, without drawing the board. Each game
+ * has its own game state, so games can be played on separate threads.
+ */
+void play_batch_game(void* arg, int job) {
+    struct BatchGame* entry = &((struct Batch*) arg)->games[job];
+    if (entry->status) {
+        return;
+    }
+
+    struct GameState game;
+    memset(&game, 0, sizeof(struct GameState));
+    game.p1type = entry->p1type;
+    game.p2type = entry->p2type;
+
+    if (entry->filename) {
+        if ((entry->status = load_game(&game, entry->filename))) {
+            free_game(&game);
+            return;
+        }
+        entry->height = game.height;
+        entry->width = game.width;
+    } else {
+        game.height = entry->height;
+        game.width = entry->width;
+        init_game_variables(&game);
+        init_board(&game);
+    }
+    game.started = true;
+
+    unsigned long long random = entry->seed;
+    short row, column;
+
+    //play until a string is captured, or there are no squares left
+    while (game.stoneCount < game.height * game.width) {
+        char type = (game.nextPlayer == 'O') ? game.p1type : game.p2type;
+        if (type == 'c' && !cpu_move(&game, &row, &column)) {
+            continue; //the computer's square was taken, try its next one
+        } else if (type == 'r') {
+            random_move(&game, &random, &row, &column);
+        } else if (type == 'p') {
+            pattern_move(&game, &random, &row, &column);
+        }
+
+        place_stone(&game, row, column);
+        entry->moves++;
+        if (update_strings(&game, row, column)) {
+            break;
+        }
+        next_player(&game);
+    }
+    entry->winner = game.winner;
+    free_game(&game);
+}
+
+/*
+ * prints the result of a game as a single line of JSON
+ */
+void print_result(FILE* output, struct BatchGame* game) {
+    fprintf(output, "{\"line\":%d,\"p1type\":\"%c\",\"p2type\":\"%c\","
+            "\"height\":%d,\"width\":%d,\"file\":", game->line,
+            game->p1type ? game->p1type : '?',
+            game->p2type ? game->p2type : '?', game->height, game->width);
+    if (game->filename) {
+        print_json_string(output, game->filename);
+    } else {
+        fprintf(output, "null");
+    }
+    fprintf(output, ",\"seed\":%llu,", game->seed);
+
+    if (game->status) {
+        fprintf(output, "\"status\":\"error\",\"error\":");
+        print_json_string(output, batch_error_message(game->status));
+    } else if (game->winner) {
+        fprintf(output, "\"status\":\"ok\",\"winner\":\"%c\",\"moves\":%d",
+                game->winner, game->moves);
+    } else {
+        fprintf(output, "\"status\":\"ok\",\"winner\":null,\"moves\":%d",
+                game->moves);
+    }
+    fprintf(output, "}\n");
+}
+
+int main(int argc, char** argv) {
+    int threads = default_thread_count();
+    int arg = 1;
+    char* validIntCheck;
+
+    if (argc > 2 && !strcmp(argv[1], "-j")) {
+        threads = strtol(argv[2], &validIntCheck, 10);
+        if (*validIntCheck) {
+            threads = 0;
+        }
+        arg = 3;
+    }
+    if (argc - arg < 1 || argc - arg > 2 || threads < 1) {
+        fprintf(stderr, "Usage: nogo-batch [-j threads] manifest "
+                "[results]\n");
+        return 1;
+    }
+
+    FILE* manifest = fopen(argv[arg], "r");
+    FILE* output = (argc - arg == 2) ? fopen(argv[arg + 1], "w") : stdout;
+    if (!manifest || !output) {
+        fprintf(stderr, "%s\n", error_message(4));
+        return 4;
+    }
+
+    struct Batch batch = {NULL, 0, 0};
+    read_manifest(&batch, manifest);
+    fclose(manifest);
+
+    run_jobs(batch.count, threads, play_batch_game, &batch);
+
+    for (int i = 0; i < batch.count; i++) {
+        print_result(output, &batch.games[i]);
+        free(batch.games[i].filename);
+    }
+    free(batch.games);
+    return fclose(output) ? 4 : 0;
+}
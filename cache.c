@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nogo.h"
+#include "cache.h"
+
+/*
+ * A position cache is a file of solved positions, kept as an open addressing
+ * hash table so it can be used straight from memory. Every process using the
+ * cache maps it read-only and shares the same pages. New positions are
+ * written into empty slots with pwrite(), holding a lock on the file so only
+ * one process writes at a time. Readers don't lock, so each entry carries a
+ * checksum, and an entry read while half written is treated as a different
+ * position.
+ */
+
+#define CACHE_MAGIC "NOGOCACH"
+#define CACHE_VERSION 1
+
+/* the number of slots in a new cache file */
+#define CACHE_SLOTS (1 << 20)
+
+/* the number of slots checked for a position before giving up */
+#define MAX_PROBES 16
+
+/* the start of a cache file, followed by its slots */
+struct CacheHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int entrySize; //the size of each slot
+    unsigned long long slotCount; //the number of slots, a power of two
+    unsigned long long unused; //keeps the slots aligned to their size
+};
+
+/*
+ * returns the hash of the position of an entry, ignoring its result
+ */
+static unsigned long long position_hash(struct CacheEntry* position) {
+    unsigned long long state = position->stones[0];
+    unsigned long long hash = next_random(&state);
+    state = hash ^ position->stones[1];
+    hash = next_random(&state);
+    state = hash ^ ((unsigned long long) position->height << 32 |
+            (unsigned long long) position->width << 1 | position->side);
+    return next_random(&state);
+}
+
+/*
+ * returns the checksum of an entry, which is never 0
+ */
+static unsigned long long entry_check(struct CacheEntry* entry) {
+    unsigned long long state = position_hash(entry) ^
+            ((unsigned long long) (entry->value + 2) << 8 |
+            (unsigned char) entry->move);
+    return next_random(&state) | 1;
+}
+
+/*
+ * returns true iff an entry is a complete copy of the given position
+ */
+static bool entry_matches(struct CacheEntry* entry,
+        struct CacheEntry* position) {
+    return entry->stones[0] == position->stones[0] &&
+            entry->stones[1] == position->stones[1] &&
+            entry->height == position->height &&
+            entry->width == position->width &&
+            entry->side == position->side &&
+            entry->check == entry_check(entry);
+}
+
+/*
+ * Writes the header and empty slots of a new cache file, unless another
+ * process has already done so. The file is sparse, so unused slots take no
+ * space on disk.
+ *
+ * returns false if the file couldn't be written
+ */
+static bool init_cache_file(int file) {
+    struct stat info;
+    if (fstat(file, &info)) {
+        return false;
+    } else if (info.st_size) {
+        return true;
+    }
+
+    struct CacheHeader header;
+    memset(&header, 0, sizeof(struct CacheHeader));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.entrySize = sizeof(struct CacheEntry);
+    header.slotCount = CACHE_SLOTS;
+    return pwrite(file, &header, sizeof(struct CacheHeader), 0) ==
+            sizeof(struct CacheHeader) && !ftruncate(file,
+            sizeof(struct CacheHeader) + header.slotCount *
+            sizeof(struct CacheEntry));
+}
+
+/*
+ * Opens a cache file and maps it into memory, creating it if it doesn't
+ * exist. A cache which can't be written to is only read.
+ *
+ * returns false if there is no usable cache at filename
+ */
+bool open_cache(struct PositionCache* cache, const char* filename) {
+    memset(cache, 0, sizeof(struct PositionCache));
+    cache->writable = true;
+    cache->file = open(filename, O_RDWR | O_CREAT, 0666);
+    if (cache->file < 0) {
+        cache->writable = false;
+        cache->file = open(filename, O_RDONLY);
+    }
+    if (cache->file < 0) {
+        return false;
+    }
+
+    //the first process to open the cache sets it up, while others wait
+    bool ready = true;
+    if (cache->writable) {
+        flock(cache->file, LOCK_EX);
+        ready = init_cache_file(cache->file);
+        flock(cache->file, LOCK_UN);
+    }
+
+    struct CacheHeader header;
+    struct stat info;
+    if (!ready || pread(cache->file, &header, sizeof(struct CacheHeader), 0)
+            != sizeof(struct CacheHeader) || fstat(cache->file, &info) ||
+            memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) ||
+            header.version != CACHE_VERSION ||
+            header.entrySize != sizeof(struct CacheEntry) ||
+            !header.slotCount || (header.slotCount & (header.slotCount - 1))
+            || info.st_size != sizeof(struct CacheHeader) +
+            header.slotCount * sizeof(struct CacheEntry)) {
+        close(cache->file);
+        return false;
+    }
+
+    cache->mapSize = info.st_size;
+    cache->map = mmap(NULL, cache->mapSize, PROT_READ, MAP_SHARED,
+            cache->file, 0);
+    if (cache->map == MAP_FAILED) {
+        close(cache->file);
+        return false;
+    }
+    cache->entries = (struct CacheEntry*) ((char*) cache->map +
+            sizeof(struct CacheHeader));
+    cache->slotCount = header.slotCount;
+    return true;
+}
+
+/*
+ * unmaps and closes a cache opened with open_cache()
+ */
+void close_cache(struct PositionCache* cache) {
+    munmap(cache->map, cache->mapSize);
+    close(cache->file);
+}
+
+/*
+ * Looks up the position given by the stones, size and side of an entry,
+ * filling in its value and move if found.
+ *
+ * returns true iff the position was found
+ */
+bool cache_probe(struct PositionCache* cache, struct CacheEntry* position) {
+    unsigned long long slot = position_hash(position);
+    for (int i = 0; i < MAX_PROBES; i++, slot++) {
+        //copy the entry, as it may be written to while being checked
+        struct CacheEntry entry = cache->entries[slot &
+                (cache->slotCount - 1)];
+        if (!entry.check) {
+            return false;
+        } else if (entry_matches(&entry, position)) {
+            position->value = entry.value;
+            position->move = entry.move;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * adds a solved position to the cache, if there is room near its slot and
+ * it isn't there already
+ */
+void cache_store(struct PositionCache* cache, struct CacheEntry* position) {
+    if (!cache->writable) {
+        return;
+    }
+    position->unused = 0;
+    position->check = entry_check(position);
+
+    flock(cache->file, LOCK_EX);
+    unsigned long long slot = position_hash(position);
+    for (int i = 0; i < MAX_PROBES; i++, slot++) {
+        slot &= cache->slotCount - 1;
+        struct CacheEntry* entry = &cache->entries[slot];
+        if (!entry->check) {
+            pwrite(cache->file, position, sizeof(struct CacheEntry),
+                    sizeof(struct CacheHeader) +
+                    slot * sizeof(struct CacheEntry));
+            break;
+        } else if (entry_matches(entry, position)) {
+            break;
+        }
+    }
+    flock(cache->file, LOCK_UN);
+}
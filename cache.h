@@ -0,0 +1,28 @@
+#include <stdbool.h>
+
+/* a solved position, as stored in a position cache (see cache.c) */
+struct CacheEntry {
+    unsigned long long stones[2]; //the 'O' and 'X' stones, a bit per square
+    short height; //the number of vertical squares on the board
+    short width; //the number of horizontal squares on the board
+    signed char side; //the player to move, 0 for 'O' or 1 for 'X'
+    signed char value; //1, 0 or -1 for a win, draw or loss of the player
+    signed char move; //the best move, as row * width + column, or -1
+    signed char unused;
+    unsigned long long check; //a checksum of the entry, or 0 if unused
+};
+
+/* a position cache file, mapped into memory */
+struct PositionCache {
+    int file; //the cache's file descriptor
+    bool writable; //false if the file could only be opened to read
+    void* map; //the mapped file, starting with its header
+    size_t mapSize; //the size of the file
+    struct CacheEntry* entries; //the slots of the cache
+    unsigned long long slotCount; //the number of slots, a power of two
+};
+
+bool open_cache(struct PositionCache* cache, const char* filename);
+void close_cache(struct PositionCache* cache);
+bool cache_probe(struct PositionCache* cache, struct CacheEntry* position);
+void cache_store(struct PositionCache* cache, struct CacheEntry* position);
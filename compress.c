@@ -0,0 +1,187 @@
+#include <string.h>
+#include "compress.h"
+
+/*
+ * A small LZ77 compressor for blocks of self-play records, in the sequence
+ * format of LZ4. Each sequence is a token byte, whose high 4 bits give the
+ * number of literals and low 4 bits the length of the match after them,
+ * less MIN_MATCH. A value of 15 in either is continued in following bytes,
+ * each adding up to 255. The literals follow, then the match's 2 byte
+ * offset back into the output, little-endian, then any bytes continuing the
+ * match length. The last sequence of a block has only literals.
+ *
+ * Consecutive positions of a game differ by a single stone, so most of a
+ * block is long matches of the position before.
+ */
+
+/* the shortest match worth encoding */
+#define MIN_MATCH 4
+
+/* the furthest back a match can start */
+#define MAX_OFFSET 65535
+
+/* matches are found through a hash table of the last place each run of
+ * MIN_MATCH bytes was seen */
+#define HASH_BITS 14
+
+/*
+ * returns the hash table index for the MIN_MATCH bytes at the given place
+ */
+static unsigned int hash_bytes(const unsigned char* bytes) {
+    unsigned int value;
+    memcpy(&value, bytes, sizeof(value));
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+ * writes a length which didn't fit in its half of a token, returning the
+ * place after it
+ */
+static unsigned char* write_length(unsigned char* output, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *output++ = 255;
+    }
+    *output++ = length;
+    return output;
+}
+
+/*
+ * writes a sequence of literals and the match after them, or just the
+ * literals if matchLength is 0, returning the place after it
+ */
+static unsigned char* write_sequence(unsigned char* output,
+        const unsigned char* literals, size_t literalCount, size_t offset,
+        size_t matchLength) {
+    unsigned char* token = output++;
+    *token = (literalCount < 15 ? literalCount : 15) << 4;
+    if (literalCount >= 15) {
+        output = write_length(output, literalCount - 15);
+    }
+    memcpy(output, literals, literalCount);
+    output += literalCount;
+
+    if (matchLength) {
+        *output++ = offset & 0xFF;
+        *output++ = offset >> 8;
+        matchLength -= MIN_MATCH;
+        *token |= matchLength < 15 ? matchLength : 15;
+        if (matchLength >= 15) {
+            output = write_length(output, matchLength - 15);
+        }
+    }
+    return output;
+}
+
+/*
+ * returns the most a block of the given size can take once compressed
+ */
+size_t compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+/*
+ * Compresses a block into output, which must have room for
+ * compress_bound(size) bytes.
+ *
+ * returns the size of the compressed block
+ */
+size_t compress_block(const unsigned char* input, size_t size,
+        unsigned char* output) {
+    const unsigned char* table[1 << HASH_BITS];
+    memset(table, 0, sizeof(table));
+    const unsigned char* end = input + size;
+    const unsigned char* literals = input;
+    unsigned char* start = output;
+
+    for (const unsigned char* next = input; next + MIN_MATCH <= end; ) {
+        const unsigned char** entry = &table[hash_bytes(next)];
+        const unsigned char* match = *entry;
+        *entry = next;
+        if (!match || next - match > MAX_OFFSET ||
+                memcmp(match, next, MIN_MATCH)) {
+            next++;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (next + length < end && match[length] == next[length]) {
+            length++;
+        }
+        output = write_sequence(output, literals, next - literals,
+                next - match, length);
+        next += length;
+        literals = next;
+    }
+    output = write_sequence(output, literals, end - literals, 0, 0);
+    return output - start;
+}
+
+/*
+ * reads the rest of a length continued after its token, into length
+ *
+ * returns false if the block ends first
+ */
+static bool read_length(const unsigned char** input, const unsigned char* end,
+        size_t* length) {
+    unsigned char byte;
+    do {
+        if (*input >= end) {
+            return false;
+        }
+        byte = *(*input)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/*
+ * Decompresses a block made by compress_block() into output, which is
+ * rawSize bytes long.
+ *
+ * returns false if the block is corrupt, or doesn't decompress to exactly
+ * rawSize bytes
+ */
+bool decompress_block(const unsigned char* input, size_t size,
+        unsigned char* output, size_t rawSize) {
+    const unsigned char* end = input + size;
+    unsigned char* start = output;
+    unsigned char* outputEnd = output + rawSize;
+
+    while (input < end) {
+        unsigned char token = *input++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !read_length(&input, end, &literalCount)) {
+            return false;
+        } else if (literalCount > (size_t) (end - input) ||
+                literalCount > (size_t) (outputEnd - output)) {
+            return false;
+        }
+        memcpy(output, input, literalCount);
+        output += literalCount;
+        input += literalCount;
+        if (input == end) {
+            break; //the last sequence has no match
+        }
+
+        if (end - input < 2) {
+            return false;
+        }
+        size_t offset = input[0] | input[1] << 8;
+        input += 2;
+        size_t length = token & 15;
+        if (length == 15 && !read_length(&input, end, &length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (!offset || offset > (size_t) (output - start) ||
+                length > (size_t) (outputEnd - output)) {
+            return false;
+        }
+
+        //copy a byte at a time, as a match may overlap its own output
+        for (const unsigned char* match = output - offset; length--; ) {
+            *output++ = *match++;
+        }
+    }
+    return output == outputEnd;
+}
@@ -0,0 +1,8 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+size_t compress_bound(size_t size);
+size_t compress_block(const unsigned char* input, size_t size,
+        unsigned char* output);
+bool decompress_block(const unsigned char* input, size_t size,
+        unsigned char* output, size_t rawSize);
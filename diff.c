@@ -0,0 +1,567 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "nogo.h"
+#include "reference.h"
+#include "pool.h"
+
+/* the number of mismatches described in full */
+#define MAX_REPORTS 10
+
+/* the totals of a run of games, shared between the threads playing them */
+struct DiffRun {
+    unsigned long long seed; //the seed of the first game
+    int maxSize; //the largest height and width of a board
+
+    unsigned long long moves; //the number of stones placed
+    unsigned long long referenceTime; //nanoseconds spent in the reference
+    unsigned long long engineTime; //nanoseconds spent in the engine
+    int mismatches; //the number of games where the engines disagreed
+    char reports[MAX_REPORTS][160]; //descriptions of the first mismatches
+};
+
+/*
+ * returns the current time in nanoseconds
+ */
+long long clock_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Checks that the engine and reference have the same stones, and split them
+ * into the same strings, even if the IDs of those strings differ. Singletons
+ * must have an ID of 0 in both. The engine's patterns of empty squares must
+ * match its board.
+ *
+ * returns NULL if they match, or a description of the difference
+ */
+const char* compare_boards(struct GameState* game, struct RefGame* ref,
+        short* row, short* column) {
+    if (game->stringIdCount != ref->stringIdCount) {
+        *row = *column = -1; //not a difference of any one square
+        return "string counts differ";
+    }
+    int* engineToRef = calloc(game->stringIdCount + 1, sizeof(int));
+    int* refToEngine = calloc(ref->stringIdCount + 1, sizeof(int));
+    const char* difference = NULL;
+
+    for (int square = 0; square < game->height * game->width &&
+            !difference; square++) {
+        *row = square / game->width;
+        *column = square % game->width;
+        int engineId = get_string_id(game, *row, *column);
+        int refId = ref->stringIds[*row][*column];
+
+        if (get_stone(game, *row, *column) !=
+                ref_get_stone(ref, *row, *column)) {
+            difference = "stones differ";
+        } else if (engineId < 0 || engineId > game->stringIdCount ||
+                refId < 0 || refId > ref->stringIdCount ||
+                (engineId == 0) != (refId == 0)) {
+            difference = "string IDs differ";
+        } else if (get_stone(game, *row, *column) == '.' &&
+                get_pattern(game, *row, *column) !=
+                compute_pattern(game, *row, *column)) {
+            difference = "patterns differ from the board";
+        } else if (engineId == 0) {
+            continue;
+        } else if (!engineToRef[engineId] && !refToEngine[refId]) {
+            //every string must map to exactly one string of the other
+            engineToRef[engineId] = refId;
+            refToEngine[refId] = engineId;
+        } else if (engineToRef[engineId] != refId ||
+                refToEngine[refId] != engineId) {
+            difference = "strings differ";
+        }
+    }
+    free(engineToRef);
+    free(refToEngine);
+    return difference;
+}
+
+/*
+ * Checks the reference's strings against the stones on its board: adjacent
+ * stones of the same player share an ID, stones on their own have ID 0, and
+ * each ID belongs to exactly one connected group of stones.
+ *
+ * returns NULL if they match, or a description of the difference
+ */
+const char* check_strings(struct RefGame* ref) {
+    short height = ref->height, width = ref->width;
+    int groups = 0; //connected groups of two or more stones
+    char* visited = calloc(height * width, 1);
+    int* stack = malloc(sizeof(int) * height * width);
+    const char* difference = NULL;
+
+    for (int square = 0; square < height * width && !difference; square++) {
+        short row = square / width, column = square % width;
+        char stone = ref->board[row][column];
+        if (stone == '.' || visited[square]) {
+            continue;
+        }
+
+        //flood fill the group, checking it shares an ID
+        int size = 0, id = ref->stringIds[row][column];
+        stack[size++] = square;
+        visited[square] = 1;
+        for (int next = 0; next < size; next++) {
+            short groupRow = stack[next] / width;
+            short groupColumn = stack[next] % width;
+            if (ref->stringIds[groupRow][groupColumn] != id) {
+                difference = "string IDs don't match the board";
+            }
+            short adjacent[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+            for (int i = 0; i < 4; i++) {
+                short adjacentRow = groupRow + adjacent[i][0];
+                short adjacentColumn = groupColumn + adjacent[i][1];
+                int adjacentSquare = adjacentRow * width + adjacentColumn;
+                if (ref_get_stone(ref, adjacentRow, adjacentColumn) == stone
+                        && !visited[adjacentSquare]) {
+                    visited[adjacentSquare] = 1;
+                    stack[size++] = adjacentSquare;
+                }
+            }
+        }
+        if ((size == 1) != (id == 0)) {
+            difference = "string IDs don't match the board";
+        }
+        groups += (size > 1);
+    }
+    if (!difference && groups != ref->stringIdCount) {
+        difference = "string IDs aren't one per string";
+    }
+    free(visited);
+    free(stack);
+    return difference;
+}
+
+/*
+ * Checks the engine's strings in atari against the reference's board. Each
+ * player's atari set must hold every string with one liberty exactly once,
+ * with that liberty, and its dead count must be the number of strings with
+ * none. Allocated tiles must count the strings in atari at each liberty.
+ *
+ * returns NULL if they match, or a description of the difference
+ */
+const char* compare_ataris(struct GameState* game, struct RefGame* ref,
+        short* row, short* column) {
+    short height = ref->height, width = ref->width;
+    int* groups = malloc(sizeof(int) * height * width); //each stone's string
+    int* stack = malloc(sizeof(int) * height * width);
+    int* counted = malloc(sizeof(int) * height * width); //liberty's string
+    int* liberties = malloc(sizeof(int) * height * width);
+    int* lastLiberty = malloc(sizeof(int) * height * width);
+    char* groupStones = malloc(height * width); //each string's player
+    char* seen = calloc(height * width, 1); //strings found in the engine
+    int groupCount = 0;
+    const char* difference = NULL;
+    short adjacent[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+
+    for (int square = 0; square < height * width; square++) {
+        groups[square] = counted[square] = -1;
+    }
+    //flood fill each string, counting its liberties
+    for (int square = 0; square < height * width; square++) {
+        char stone = ref->board[square / width][square % width];
+        if (stone == '.' || groups[square] >= 0) {
+            continue;
+        }
+        int group = groupCount++;
+        int size = 0;
+        liberties[group] = 0;
+        groupStones[group] = stone;
+        stack[size++] = square;
+        groups[square] = group;
+        for (int next = 0; next < size; next++) {
+            for (int i = 0; i < 4; i++) {
+                short adjacentRow = stack[next] / width + adjacent[i][0];
+                short adjacentColumn = stack[next] % width + adjacent[i][1];
+                int adjacentSquare = adjacentRow * width + adjacentColumn;
+                char adjacentStone = ref_get_stone(ref, adjacentRow,
+                        adjacentColumn);
+                if (adjacentStone == '.' && counted[adjacentSquare] != group) {
+                    counted[adjacentSquare] = group;
+                    liberties[group]++;
+                    lastLiberty[group] = adjacentSquare;
+                } else if (adjacentStone == stone &&
+                        groups[adjacentSquare] < 0) {
+                    groups[adjacentSquare] = group;
+                    stack[size++] = adjacentSquare;
+                }
+            }
+        }
+    }
+
+    for (int player = 0; player < 2 && !difference; player++) {
+        char stone = player ? 'X' : 'O';
+        int count;
+        struct Atari* ataris = get_ataris(game, stone, &count);
+        for (int i = 0; i < count && !difference; i++) {
+            *row = ataris[i].stone.row;
+            *column = ataris[i].stone.column;
+            int group = (*row >= 0 && *row < height && *column >= 0 &&
+                    *column < width) ? groups[*row * width + *column] : -1;
+            if (group < 0 || groupStones[group] != stone ||
+                    liberties[group] != 1) {
+                difference = "ataris differ";
+            } else if (seen[group]++) {
+                difference = "string in atari more than once";
+            } else if (ataris[i].liberty.row * width +
+                    ataris[i].liberty.column != lastLiberty[group]) {
+                difference = "atari liberties differ";
+            }
+        }
+
+        //every string in atari must have been found, and no others
+        int ataried = 0, dead = 0;
+        for (int group = 0; group < groupCount; group++) {
+            if (groupStones[group] == stone) {
+                ataried += (liberties[group] == 1);
+                dead += (liberties[group] == 0);
+            }
+        }
+        if (!difference && (ataried != count ||
+                dead != get_atari_set(game, stone)->deadCount)) {
+            *row = *column = -1;
+            difference = ataried != count ? "atari counts differ" :
+                    "dead counts differ";
+        }
+
+        //allocated tiles count the strings in atari at each liberty
+        for (int square = 0; square < height * width; square++) {
+            counted[square] = 0;
+        }
+        for (int i = 0; i < count && !difference; i++) {
+            counted[ataris[i].liberty.row * width +
+                    ataris[i].liberty.column]++;
+        }
+        for (int square = 0; square < height * width && !difference;
+                square++) {
+            *row = square / width;
+            *column = square % width;
+            struct Tile* tile = get_tile(game, *row, *column, false);
+            if (tile && tile->atariLiberties[player][*row & TILE_MASK]
+                    [*column & TILE_MASK] != counted[square]) {
+                difference = "atari liberty counts differ";
+            }
+        }
+    }
+    free(groups);
+    free(stack);
+    free(counted);
+    free(liberties);
+    free(lastLiberty);
+    free(groupStones);
+    free(seen);
+    return difference;
+}
+
+/*
+ * records a game where the engines disagreed
+ */
+void report_mismatch(struct DiffRun* run, unsigned long long seed,
+        int move, const char* difference, short row, short column) {
+    int report = __atomic_fetch_add(&run->mismatches, 1, __ATOMIC_RELAXED);
+    if (report < MAX_REPORTS) {
+        snprintf(run->reports[report], sizeof(run->reports[report]),
+                "seed %llu, move %d: %s at %d %d", seed, move, difference,
+                row, column);
+    }
+}
+
+/*
+ * Fills the board of both engines with stones at random, as if a saved game
+ * had been loaded, including strings which may already have been captured.
+ * The engine really does load them, from a save of its board.
+ *
+ * returns false if the save couldn't be written or loaded
+ */
+bool fill_boards(struct GameState* game, struct RefGame* ref,
+        unsigned long long* random) {
+    int density = next_random(random) % 60; //the percentage of stones
+    for (short row = 0; row < game->height; row++) {
+        for (short column = 0; column < game->width; column++) {
+            if (next_random(random) % 100 < density) {
+                char stone = (next_random(random) & 1) ? 'X' : 'O';
+                set_stone(game, row, column, stone);
+                ref->board[row][column] = stone;
+            }
+        }
+    }
+    for (short row = 0; row < ref->height; row++) {
+        for (short column = 0; column < ref->width; column++) {
+            if (ref_get_stone(ref, row, column) != '.') {
+                ref_update_strings(ref, row, column);
+            }
+        }
+    }
+    if (next_random(random) & 1) {
+        next_player(game);
+        ref_next_player(ref);
+    }
+
+    char filename[] = "/tmp/nogo-diff-XXXXXX";
+    int file = mkstemp(filename);
+    if (file < 0) {
+        return false;
+    }
+    close(file);
+    char p1type = game->p1type, p2type = game->p2type;
+    bool saved = save_game(game, filename);
+    free_game(game);
+    memset(game, 0, sizeof(struct GameState));
+    bool loaded = saved && !load_game(game, filename);
+    unlink(filename);
+    game->p1type = p1type;
+    game->p2type = p2type;
+    return loaded;
+}
+
+/*
+ * Times replaying a game's moves on each engine alone, away from the checks,
+ * starting from the stones of start, or an empty board if it is NULL
+ */
+void time_moves(struct DiffRun* run, short height, short width,
+        struct GameState* start, char nextPlayer, struct Point* moves,
+        int moveCount) {
+    struct GameState game;
+    struct RefGame ref;
+
+    memset(&game, 0, sizeof(struct GameState));
+    game.height = height;
+    game.width = width;
+    init_game_variables(&game);
+    init_board(&game);
+    ref_init_game(&ref, height, width);
+
+    //start from the same stones as the checked game
+    for (short row = 0; start && row < height; row++) {
+        for (short column = 0; column < width; column++) {
+            char stone = get_stone(start, row, column);
+            if (stone != '.') {
+                set_stone(&game, row, column, stone);
+                ref.board[row][column] = stone;
+            }
+        }
+    }
+    for (short row = 0; row < height; row++) {
+        for (short column = 0; column < width; column++) {
+            if (get_stone(&game, row, column) != '.') {
+                update_strings(&game, row, column);
+                ref_update_strings(&ref, row, column);
+            }
+        }
+    }
+    find_ataris(&game);
+    game.nextPlayer = ref.nextPlayer = nextPlayer;
+    game.started = ref.started = true;
+
+    long long begin = clock_ns();
+    for (int i = 0; i < moveCount; i++) {
+        place_stone(&game, moves[i].row, moves[i].column);
+        update_strings(&game, moves[i].row, moves[i].column);
+        next_player(&game);
+    }
+    long long middle = clock_ns();
+    for (int i = 0; i < moveCount; i++) {
+        ref_place_stone(&ref, moves[i].row, moves[i].column);
+        ref_update_strings(&ref, moves[i].row, moves[i].column);
+        ref_next_player(&ref);
+    }
+    long long end = clock_ns();
+
+    __atomic_fetch_add(&run->engineTime, middle - begin, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&run->referenceTime, end - middle, __ATOMIC_RELAXED);
+    free_game(&game);
+    ref_free_game(&ref);
+}
+
+/*
+ * Plays a game through both the engine and the reference, checking they
+ * agree after every move. The seed decides the board size, the players,
+ * and whether the game starts from a random position.
+ */
+void play_diff_game(void* arg, int job) {
+    struct DiffRun* run = arg;
+    unsigned long long seed = run->seed + job;
+    unsigned long long random = seed;
+
+    short height = 4 + next_random(&random) % (run->maxSize - 3);
+    short width = 4 + next_random(&random) % (run->maxSize - 3);
+    int kind = seed % 5;
+    const char* playerTypes[5] = {"cc", "cr", "rr", "pr", "rc"};
+
+    struct GameState game;
+    struct RefGame ref;
+    memset(&game, 0, sizeof(struct GameState));
+    game.height = height;
+    game.width = width;
+    game.p1type = playerTypes[kind][0];
+    game.p2type = playerTypes[kind][1];
+    init_game_variables(&game);
+    init_board(&game);
+    ref_init_game(&ref, height, width);
+
+    //the last kind of game starts from a random position
+    const char* difference = NULL;
+    short row = -1, column = -1;
+    if (kind == 4 && !fill_boards(&game, &ref, &random)) {
+        difference = "random position didn't load";
+    }
+    game.started = ref.started = true;
+
+    char startPlayer = game.nextPlayer;
+    struct Point* moves = malloc(sizeof(struct Point) * height * width);
+    int moveCount = 0;
+    if (!difference) {
+        difference = compare_boards(&game, &ref, &row, &column);
+    }
+    if (!difference) {
+        difference = compare_ataris(&game, &ref, &row, &column);
+    }
+    if (!difference) {
+        difference = check_strings(&ref);
+    }
+    struct GameState start;
+    if (!difference && kind == 4) {
+        //keep the random position to time the engines from later
+        memset(&start, 0, sizeof(struct GameState));
+        start.height = height;
+        start.width = width;
+        init_board(&start);
+        for (row = 0; row < height; row++) {
+            for (column = 0; column < width; column++) {
+                set_stone(&start, row, column, get_stone(&game, row, column));
+            }
+        }
+    }
+
+    while (!difference && game.stoneCount < height * width) {
+        char type = (game.nextPlayer == 'O') ? game.p1type : game.p2type;
+        if (type == 'c') {
+            bool valid = cpu_move(&game, &row, &column);
+            int refRow = (ref.nextPlayer == 'X') ? ref.nextMoveXY :
+                    ref.nextMoveOY;
+            int refColumn = (ref.nextPlayer == 'X') ? ref.nextMoveXX :
+                    ref.nextMoveOX;
+            bool refValid = (ref_get_stone(&ref, refRow, refColumn) == '.');
+            ref_next_cpu_move(&ref);
+            if (refRow != row || refColumn != column || refValid != valid ||
+                    ref.nextMoveXY != game.nextMoveXY ||
+                    ref.nextMoveXX != game.nextMoveXX ||
+                    ref.nextMoveOY != game.nextMoveOY ||
+                    ref.nextMoveOX != game.nextMoveOX) {
+                difference = "computer moves differ";
+                break;
+            } else if (!valid) {
+                continue;
+            }
+        } else if (type == 'p') {
+            pattern_move(&game, &random, &row, &column);
+        } else {
+            random_move(&game, &random, &row, &column);
+        }
+
+        moves[moveCount].row = row;
+        moves[moveCount++].column = column;
+        bool placed = place_stone(&game, row, column);
+        bool refPlaced = ref_place_stone(&ref, row, column);
+        bool captured = update_strings(&game, row, column);
+        bool refCaptured = ref_update_strings(&ref, row, column);
+
+        if (placed != refPlaced || captured != refCaptured ||
+                game.winner != ref.winner) {
+            difference = "winners differ";
+        } else {
+            short differentRow, differentColumn;
+            if ((difference = compare_boards(&game, &ref, &differentRow,
+                    &differentColumn)) ||
+                    (difference = compare_ataris(&game, &ref, &differentRow,
+                    &differentColumn)) ||
+                    (difference = check_strings(&ref))) {
+                row = differentRow;
+                column = differentColumn;
+            }
+        }
+        if (captured || difference) {
+            break;
+        }
+        next_player(&game);
+        ref_next_player(&ref);
+    }
+
+    __atomic_fetch_add(&run->moves, moveCount, __ATOMIC_RELAXED);
+    if (difference) {
+        report_mismatch(run, seed, moveCount, difference, row, column);
+    } else {
+        time_moves(run, height, width, kind == 4 ? &start : NULL,
+                startPlayer, moves, moveCount);
+        if (kind == 4) {
+            free_game(&start);
+        }
+    }
+    free(moves);
+    free_game(&game);
+    ref_free_game(&ref);
+}
+
+int main(int argc, char** argv) {
+    int threads = default_thread_count();
+    int games = 10000;
+    int seconds = 0; //how long to keep playing rounds of games, or 0 for one
+    struct DiffRun run;
+    memset(&run, 0, sizeof(struct DiffRun));
+    run.seed = 1;
+    run.maxSize = 19;
+
+    int option;
+    while ((option = getopt(argc, argv, "j:n:s:m:t:")) != -1) {
+        switch (option) {
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'n':
+                games = atoi(optarg);
+                break;
+            case 's':
+                run.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'm':
+                run.maxSize = atoi(optarg);
+                break;
+            case 't':
+                seconds = atoi(optarg);
+                break;
+            default:
+                threads = 0;
+        }
+    }
+    if (optind != argc || threads < 1 || games < 1 || seconds < 0 ||
+            !in_size_bounds(run.maxSize, run.maxSize)) {
+        fprintf(stderr, "Usage: nogo-diff [-j threads] [-n games] [-s seed] "
+                "[-m maxsize] [-t seconds]\n");
+        return 1;
+    }
+
+    //with -t, rounds of games carry on from the seeds of the last round
+    long long end = clock_ns() + seconds * 1000000000LL;
+    unsigned long long firstSeed = run.seed;
+    do {
+        run_jobs(games, threads, play_diff_game, &run);
+        run.seed += games;
+    } while (clock_ns() < end && !run.mismatches);
+
+    for (int i = 0; i < run.mismatches && i < MAX_REPORTS; i++) {
+        fprintf(stderr, "Mismatch: %s\n", run.reports[i]);
+    }
+    printf("games %llu, moves %llu, mismatches %d\n", run.seed - firstSeed,
+            run.moves, run.mismatches);
+    printf("reference %.3fs, engine %.3fs, speedup %.2fx\n",
+            run.referenceTime / 1e9, run.engineTime / 1e9,
+            run.engineTime ? (double) run.referenceTime / run.engineTime : 0);
+    return run.mismatches ? 2 : 0;
+}
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include "nogo.h"
+#include "libnogo.h"
+
+/*
+ * The library wraps a game state, playing moves the same way as nogo's own
+ * game loop, but without drawing the board or reading from standard input.
+ */
+struct NogoGame {
+    struct GameState state;
+};
+
+/*
+ * returns the message describing a status returned by the library
+ */
+const char* nogo_status_message(int status) {
+    switch (status) {
+        case NOGO_OK:
+            return "OK";
+        case NOGO_INVALID_MOVE:
+            return "Invalid move";
+        case NOGO_GAME_OVER:
+            return "The game is over";
+        case NOGO_BOARD_FULL:
+            return "The board is full";
+        case NOGO_NO_MEMORY:
+            return "Out of memory";
+        case NOGO_INVALID_ARGUMENT:
+            return "Invalid argument";
+        case NOGO_NO_MOVE:
+            return "The computer player found no move";
+    }
+    const char* message = error_message(status);
+    return message ? message : "Unknown status";
+}
+
+/*
+ * allocates a handle with an empty game state, for the caller to set up
+ */
+static NogoGame* new_game(void) {
+    NogoGame* game = calloc(1, sizeof(NogoGame));
+    if (game) {
+        //both players are computers, so cpu_move() may be used for either
+        game->state.p1type = 'c';
+        game->state.p2type = 'c';
+    }
+    return game;
+}
+
+/*
+ * Creates a new game on an empty board of the given size, into game.
+ *
+ * returns NOGO_OK, or the reason the game couldn't be created
+ */
+int nogo_create(NogoGame** game, int height, int width) {
+    if (!game) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    *game = NULL;
+    if (!in_size_bounds(height, width)) {
+        return NOGO_INVALID_DIMENSION;
+    }
+    NogoGame* created = new_game();
+    if (!created) {
+        return NOGO_NO_MEMORY;
+    }
+
+    created->state.height = height;
+    created->state.width = width;
+    init_game_variables(&created->state);
+    init_board(&created->state);
+    created->state.started = true;
+    *game = created;
+    return NOGO_OK;
+}
+
+/*
+ * Loads a game saved by nogo or nogo_save() into game.
+ *
+ * returns NOGO_OK, or the reason the game couldn't be loaded
+ */
+int nogo_load(NogoGame** game, const char* filename) {
+    if (!game || !filename) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    *game = NULL;
+    NogoGame* loaded = new_game();
+    if (!loaded) {
+        return NOGO_NO_MEMORY;
+    }
+
+    int status = load_game(&loaded->state, filename);
+    if (status) {
+        nogo_destroy(loaded);
+        return status;
+    }
+    loaded->state.started = true;
+    *game = loaded;
+    return NOGO_OK;
+}
+
+/*
+ * frees a game and everything it holds, doing nothing if it is NULL
+ */
+void nogo_destroy(NogoGame* game) {
+    if (game) {
+        free_game(&game->state);
+        free(game);
+    }
+}
+
+/*
+ * Saves a game in nogo's file format, so it can be loaded by nogo_load() or
+ * played on by nogo.
+ *
+ * returns NOGO_OK, or NOGO_FILE_ERROR if the file couldn't be written
+ */
+int nogo_save(NogoGame* game, const char* filename) {
+    if (!game || !filename) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    return save_game(&game->state, filename) ? NOGO_OK : NOGO_FILE_ERROR;
+}
+
+/*
+ * Plays a stone for the next player at the given square, then passes the
+ * turn to the other player unless the move ended the game.
+ *
+ * returns NOGO_OK, or the reason the move couldn't be played
+ */
+int nogo_play(NogoGame* game, int row, int column) {
+    if (!game) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    struct GameState* state = &game->state;
+    if (state->winner) {
+        return NOGO_GAME_OVER;
+    } else if (state->stoneCount >= state->height * state->width) {
+        return NOGO_BOARD_FULL;
+    } else if (row < 0 || row >= state->height || column < 0 ||
+            column >= state->width || !place_stone(state, row, column)) {
+        return NOGO_INVALID_MOVE;
+    }
+
+    if (!update_strings(state, row, column)) {
+        next_player(state);
+    }
+    return NOGO_OK;
+}
+
+/*
+ * Plays the move nogo's computer player would make for the next player,
+ * storing its square in row and column if they aren't NULL.
+ *
+ * returns NOGO_OK, or the reason no move could be played
+ */
+int nogo_computer_move(NogoGame* game, int* row, int* column) {
+    if (!game) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    struct GameState* state = &game->state;
+    if (state->winner) {
+        return NOGO_GAME_OVER;
+    } else if (state->stoneCount >= state->height * state->width) {
+        //cpu_move() would never find a free square
+        return NOGO_BOARD_FULL;
+    }
+
+    //cpu_move() moves on to an empty square when its square was taken, so
+    //this only fails once, but it is bounded in case the board isn't sound
+    short moveRow, moveColumn;
+    int attempts = state->height * state->width;
+    while (!cpu_move(state, &moveRow, &moveColumn)) {
+        if (--attempts == 0) {
+            return NOGO_NO_MOVE;
+        }
+    }
+    if (row) {
+        *row = moveRow;
+    }
+    if (column) {
+        *column = moveColumn;
+    }
+    return nogo_play(game, moveRow, moveColumn);
+}
+
+/*
+ * stores the number of rows and columns of the board in height and width
+ *
+ * returns NOGO_OK, or NOGO_INVALID_ARGUMENT if any of them are NULL
+ */
+int nogo_get_size(const NogoGame* game, int* height, int* width) {
+    if (!game || !height || !width) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    *height = game->state.height;
+    *width = game->state.width;
+    return NOGO_OK;
+}
+
+/*
+ * returns the player to move, 'O' or 'X', or '\0' if game is NULL
+ */
+char nogo_next_player(const NogoGame* game) {
+    return game ? game->state.nextPlayer : '\0';
+}
+
+/*
+ * returns the player who has won, or '\0' if nobody has won yet
+ */
+char nogo_winner(const NogoGame* game) {
+    return game ? game->state.winner : '\0';
+}
+
+/*
+ * returns the stone on a square, 'O', 'X' or '.' if it is empty, or '\0' if
+ * the square isn't on the board
+ */
+char nogo_get_stone(const NogoGame* game, int row, int column) {
+    if (!game || row < 0 || row >= game->state.height || column < 0 ||
+            column >= game->state.width) {
+        return '\0';
+    }
+    //get_stone() doesn't change the game, it just isn't declared const
+    return get_stone((struct GameState*) &game->state, row, column);
+}
+
+/*
+ * returns the number of stones on the board, which fills up at height *
+ * width stones, or -1 if game is NULL
+ */
+int nogo_stone_count(const NogoGame* game) {
+    return game ? game->state.stoneCount : -1;
+}
+
+/*
+ * returns the number of liberties of the string holding the stone on a
+ * square, 0 or 1, or 2 for two or more, or -1 if the square has no stone
+ */
+int nogo_string_liberties(NogoGame* game, int row, int column) {
+    char stone = nogo_get_stone(game, row, column);
+    if (stone != 'O' && stone != 'X') {
+        return -1;
+    }
+    struct Point liberty;
+    return string_liberties(&game->state, row, column, &liberty);
+}
+
+/*
+ * returns the number of a player's strings in atari, or -1 if game is NULL or
+ * player isn't 'O' or 'X'
+ */
+int nogo_atari_count(const NogoGame* game, char player) {
+    if (!game || (player != 'O' && player != 'X')) {
+        return -1;
+    }
+    int count;
+    get_ataris((struct GameState*) &game->state, player, &count);
+    return count;
+}
+
+/*
+ * Stores the square of a stone in one of a player's strings in atari, and
+ * the square of the string's last liberty, for index from 0 up to
+ * nogo_atari_count(). Any of the squares' pointers may be NULL.
+ *
+ * returns NOGO_OK, or NOGO_INVALID_ARGUMENT if there is no such string
+ */
+int nogo_get_atari(const NogoGame* game, char player, int index,
+        int* stoneRow, int* stoneColumn, int* libertyRow,
+        int* libertyColumn) {
+    if (index < 0 || index >= nogo_atari_count(game, player)) {
+        return NOGO_INVALID_ARGUMENT;
+    }
+    int count;
+    struct Atari* atari = &get_ataris((struct GameState*) &game->state,
+            player, &count)[index];
+    if (stoneRow) {
+        *stoneRow = atari->stone.row;
+    }
+    if (stoneColumn) {
+        *stoneColumn = atari->stone.column;
+    }
+    if (libertyRow) {
+        *libertyRow = atari->liberty.row;
+    }
+    if (libertyColumn) {
+        *libertyColumn = atari->liberty.column;
+    }
+    return NOGO_OK;
+}
+
+/*
+ * returns 1 if the next player's stone on a square would take the last
+ * liberty of an opposing string, ending the game, 0 if it wouldn't, or -1 if
+ * the square isn't on the board
+ */
+int nogo_captures(const NogoGame* game, int row, int column) {
+    if (!nogo_get_stone(game, row, column)) {
+        return -1;
+    }
+    return captures_string((struct GameState*) &game->state, row, column,
+            game->state.nextPlayer);
+}
@@ -0,0 +1,67 @@
+#ifndef LIBNOGO_H
+#define LIBNOGO_H
+
+/*
+ * libnogo, the nogo engine as a library for programs which host many games.
+ *
+ * Each game lives behind its own handle, and the library keeps no state
+ * outside of its handles, so games can be played on separate threads at
+ * once. A single handle must only be used by one thread at a time.
+ *
+ * Every function reports errors by returning a status rather than printing
+ * or exiting. The statuses for bad dimensions and files are the same as the
+ * exit statuses of nogo.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the symbols exported by libnogo.so, which hides the rest of the engine */
+#define NOGO_API __attribute__((visibility("default")))
+
+/* a game in progress */
+typedef struct NogoGame NogoGame;
+
+/* the result of a call into the library */
+enum NogoStatus {
+    NOGO_OK = 0,
+    NOGO_INVALID_DIMENSION = 3, //the board size is out of bounds
+    NOGO_FILE_ERROR = 4, //a file couldn't be opened
+    NOGO_INVALID_FILE = 5, //a file isn't a valid saved game
+    NOGO_INVALID_MOVE = 7, //the square is off the board or taken
+    NOGO_GAME_OVER = 8, //a player has already won
+    NOGO_BOARD_FULL = 9, //there are no squares left, so the game is drawn
+    NOGO_NO_MEMORY = 10, //a new game couldn't be allocated
+    NOGO_INVALID_ARGUMENT = 11, //a handle or other pointer is NULL
+    NOGO_NO_MOVE = 12 //the computer player couldn't find an empty square
+};
+
+NOGO_API const char* nogo_status_message(int status);
+
+NOGO_API int nogo_create(NogoGame** game, int height, int width);
+NOGO_API int nogo_load(NogoGame** game, const char* filename);
+NOGO_API void nogo_destroy(NogoGame* game);
+NOGO_API int nogo_save(NogoGame* game, const char* filename);
+
+NOGO_API int nogo_play(NogoGame* game, int row, int column);
+NOGO_API int nogo_computer_move(NogoGame* game, int* row, int* column);
+
+NOGO_API int nogo_get_size(const NogoGame* game, int* height, int* width);
+NOGO_API char nogo_next_player(const NogoGame* game);
+NOGO_API char nogo_winner(const NogoGame* game);
+NOGO_API char nogo_get_stone(const NogoGame* game, int row, int column);
+NOGO_API int nogo_stone_count(const NogoGame* game);
+
+NOGO_API int nogo_string_liberties(NogoGame* game, int row, int column);
+NOGO_API int nogo_atari_count(const NogoGame* game, char player);
+NOGO_API int nogo_get_atari(const NogoGame* game, char player, int index,
+        int* stoneRow, int* stoneColumn, int* libertyRow,
+        int* libertyColumn);
+NOGO_API int nogo_captures(const NogoGame* game, int row, int column);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
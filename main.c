@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nogo.h"
+#include "stats.h"
+#include "solve.h"
+#include "analyze.h"
+
+/*
+ * prints an error message corresponding to the given value,
+ * and exits using that value as an exit status
+ */
+void quit(int exitValue) {
+    const char* message = error_message(exitValue);
+    if (message) {
+        fprintf(stderr, "%s\n", message);
+        exit(exitValue);
+    }
+}
+
+/* 
+ * Parses the arguments given to main into the game struct.
+ *
+ * If arguments are incorrect, this function make call exit()
+ * in the form of quit()
+ *
+ */
+void arg_parse(struct GameState* game, int runtimeArgCount,
+        char** runtimeArgs) {
+
+    //check for correct number of arguments
+    if (runtimeArgCount != 4 && runtimeArgCount != 5) {
+        quit(1);
+    }
+
+    //the first and second arg are p1's type and p2's type respectively
+    char p1type = *runtimeArgs[1], p2type = *runtimeArgs[2];
+
+    //check player type arguments are equal to only 'h' or 'c'
+    if (strlen(runtimeArgs[1]) > 1 || strlen(runtimeArgs[2]) > 1 ||
+            (p1type != 'h' && p1type != 'c') ||
+            (p2type != 'h' && p2type != 'c')) {
+        quit(2);
+    }
+    game->p1type = p1type;
+    game->p2type = p2type;
+
+    int height, width;
+    char* validIntCheck; //to see if strtol returns valid numbers
+    height = strtol(runtimeArgs[3], &validIntCheck, 10);
+
+    //check if height and width are non-numbers or are outside bounds
+    if (*validIntCheck) {
+        //height is non-numerical, try and load it as a file
+        quit(load_game(game, runtimeArgs[3]));
+    } else if (runtimeArgCount != 5) {
+        quit(1); //no file was found and no width argument was found
+    } else if (!(width = strtol(runtimeArgs[4], &validIntCheck, 10)) ||
+            *validIntCheck || !in_size_bounds(height, width)) {
+        quit(3); //width is invalid
+    } else {
+        //apply valid values to game state
+        game->height = height;
+        game->width = width;
+        init_game_variables(game);
+        init_board(game);
+    }
+}
+
+/*
+ * get the appropriate input for the player types
+ */
+char* get_input(struct GameState* game, char* input) {
+    STAT_TIMER(timer);
+
+    short row, column;
+
+    if ((game->nextPlayer == 'X' && game->p2type == 'c') ||
+            (game->nextPlayer == 'O' && game->p1type == 'c')) {
+        if (cpu_move(game, &row, &column)) {
+            sprintf(input, "%d %d\n", row, column);
+            printf("Player %c: %s", game->nextPlayer, input);
+        } else {
+            input = 0;
+        }
+
+    } else {
+        printf("Player %c> ", game->nextPlayer); 
+
+        if (!fgets(input, 72, stdin)) {
+            quit(6);
+        }
+        if (feof(stdin)) {
+            quit(6);
+        } else if (strlen(input) > 70) {
+            input = "0";
+        }
+    }
+    STAT_RECORD(STAT_GET_INPUT, timer);
+    return input;
+}
+
+/*
+ * prints the current board state to standard output
+ */
+void draw_board(struct GameState* game) {
+    STAT_TIMER(timer);
+
+    //top border
+    printf("/");
+    for(int i = 1; printf("-"), i < game->width; i++);
+    printf("\\\n");
+
+    char line[game->width + 1];
+    for (short row = 0; row < game->height; row++) {
+        copy_row(game, row, line);
+        printf("|%s|\n", line);
+    }
+
+    //bottom border
+    printf("\\");
+    for(int i = 1; printf("-"), i < game->width; i++);
+    printf("/\n");
+    STAT_RECORD(STAT_DRAW_BOARD, timer);
+}
+
+/*
+ * print the string ID of each square
+ */
+void list_ids(struct GameState* game) {
+    for (short row = 0; row < game->height; row++) {
+        for (short column = 0; column < game->width; column++) {
+            printf("%d, ", get_string_id(game, row, column));
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+
+    if (argc > 1 && !strcmp(argv[1], "--solve")) {
+        return solve_main(argc - 1, argv + 1);
+    } else if (argc > 1 && !strcmp(argv[1], "--analyze")) {
+        return analyze_main(argc - 1, argv + 1);
+    }
+
+    struct GameState gameState;
+    gameState.started = false;
+
+    arg_parse(&gameState, argc, argv);
+    draw_board(&gameState);
+    gameState.started = true;
+
+    //max input length is 70, plus a new line and the null terminator
+    char* input = malloc(sizeof(char) * 72);
+
+    while (true) {
+
+        if (!get_input(&gameState, input)) {
+            continue; //no valid input, continue
+        }
+
+        if (input[0] == '\n') {
+            continue; //no input, continue
+        } else if (input[0] == 'w') {
+            //save game, input's value after w is a file
+            input[strcspn(input, "\n")] = '\0';
+            save_game(&gameState, input + 1); 
+            continue;
+        } else if (input[0] == '~') {
+            list_ids(&gameState);
+            continue;
+        }
+
+        //get first and second arguments as integers using strtok_r
+        char* savePtr;
+        int row = next_tok_arg(input, &savePtr);
+        int column = next_tok_arg(NULL, &savePtr);
+
+        if (!place_stone(&gameState, row, column)) {
+            continue; //invalid stone, continue
+        }
+
+        draw_board(&gameState);
+
+        if (update_strings(&gameState, row, column)) {
+            // a stone was captured, end the game
+            printf("Player %c wins\n", gameState.winner);
+            return 0;
+        }
+
+        next_player(&gameState);
+    }
+    quit(6);
+}
@@ -4,92 +4,28 @@
 #include <math.h>
 #include <limits.h>
 #include "nogo.h"
+#include "stats.h"
 
 /*
- * print the string ID of each square
+ * returns the error message corresponding to an exit status, or NULL if 
+ * there isn't one
  */
-void list_ids(struct GameState* game) {
-    for (short row = 0; row < game->height; row++) {
-        for (short column = 0; column < game->width; column++) {
-            printf("%d, ", game->stringIds[row][column]);
-        }
-        printf("\n");
-    }
-}
-
-int main(int argc, char** argv) {
-
-    struct GameState gameState;
-    gameState.started = false;
-
-    arg_parse(&gameState, argc, argv);
-    draw_board(&gameState);
-    gameState.started = true;
-
-    char* input = malloc(sizeof(char) * 71); //max input length is 70
-
-    while (true) {
-
-        if (!get_input(&gameState, input)) {
-            continue; //no valid input, continue
-        }
-
-        if (input[0] == '\n') {
-            continue; //no input, continue
-        } else if (input[0] == 'w') {
-            //save game, input's value after w is a file
-            save_game(&gameState, input + 1); 
-            continue;
-        } else if (input[0] == '~') {
-            list_ids(&gameState);
-            continue;
-        }
-
-        //get first argument as an integer integer using strtok
-        int row = strtol(strtok(input, " "), NULL, 10);
-        int column = next_tok_arg(); //get next argument as integer with strtok
-
-        if (!place_stone(&gameState, row, column)) {
-            continue; //invalid stone, continue
-        }
-
-        draw_board(&gameState);
-
-        if (update_strings(&gameState, row, column)) {
-            return 0; // a stone was captured, end the game
-        }
-
-        next_player(&gameState);
-    }
-    quit(6);
-} 
-
-/*
- * prints an error message corresponding to the given value,
- * and exits using that value as an exit status
- */
-void quit(int exitValue) {
-    switch (exitValue) {
+const char* error_message(int status) {
+    switch (status) {
         case 1:
-            fprintf(stderr, "Usage: nogo p1type p2type [height width | "
-                    "filename]\n");
-            exit(1);
+            return "Usage: nogo p1type p2type [height width | filename]";
         case 2:
-            fprintf(stderr, "Invalid player type\n");
-            exit(2);
+            return "Invalid player type";
         case 3:
-            fprintf(stderr, "Invalid board dimension\n");
-            exit(3);
+            return "Invalid board dimension";
         case 4:
-            fprintf(stderr, "Unable to open file\n");
-            exit(4);
+            return "Unable to open file";
         case 5:
-            fprintf(stderr, "Incorrect file contents\n");
-            exit(5);
+            return "Incorrect file contents";
         case 6:
-            fprintf(stderr, "End of input from user\n");
-            exit(6);
+            return "End of input from user";
     }
+    return NULL;
 }
 
 /*
@@ -104,65 +40,6 @@ void next_player(struct GameState* game) {
     }
 }
 
-/* 
- * Parses the arguments given to main into the game struct.
- *
- * If arguments are incorrect, this function make call exit()
- * in the form of quit()
- *
- */
-void arg_parse(struct GameState* game, int runtimeArgCount,
-        char** runtimeArgs) {
-
-    //check for correct number of arguments
-    if (runtimeArgCount != 4 && runtimeArgCount != 5) {
-        quit(1);
-    }
-
-    //the first and second arg are p1's type and p2's type respectively
-    char p1type = *runtimeArgs[1], p2type = *runtimeArgs[2];
-
-    //check player type arguments are equal to only 'h' or 'c'
-    if (strlen(runtimeArgs[1]) > 1 || strlen(runtimeArgs[2]) > 1 ||
-            (p1type != 'h' && p1type != 'c') ||
-            (p2type != 'h' && p2type != 'c')) {
-        quit(2);
-    }
-    game->p1type = p1type;
-    game->p2type = p2type;
-
-    int height, width;
-    char* validIntCheck; //to see if strtol returns valid numbers
-    height = strtol(runtimeArgs[3], &validIntCheck, 10);
-
-    //check if height and width are non-numbers or are outside bounds
-    if (*validIntCheck) {
-        //height is non-numerical, try and load it as a file
-        load_file(game, runtimeArgs[3]);
-
-        //check each stone for adjacent stones and find appropriate string IDs
-        game->stringIdCount = 0;
-        for (short row = 0; row < game->height; row++) {
-            for (short column = 0; column < game->width; column++) {
-                if (get_stone(game, row, column) && 
-                        get_stone(game, row, column) != '.') {
-                    update_strings(game, row, column);
-                }
-            }
-        }
-    } else if (runtimeArgCount != 5) {
-        quit(1); //no file was found and no width argument was found
-    } else if (!(width = strtol(runtimeArgs[4], &validIntCheck, 10)) ||
-            *validIntCheck || !in_size_bounds(height, width)) {
-        quit(3); //width is invalid
-    } else {
-        //apply valid values to game state
-        game->height = height;
-        game->width = width;
-        init_game_variables(game);
-        init_board(game);
-    }
-}
 
 /*
  * returns whether or not the given width and height are reasonable
@@ -172,13 +49,14 @@ bool in_size_bounds(int height, int width) {
 }
 
 /*
- * returns next appropriate value from strtok after strtok has been initialised
+ * returns next appropriate value from strtok_r, given the string to start
+ * on, or NULL to continue with the string savePtr was last used for
  */
-int next_tok_arg(void) {
+int next_tok_arg(char* string, char** savePtr) {
 
     char* validIntCheck;
     char* nextArg;
-    if (!(nextArg = strtok(NULL, " "))) {
+    if (!(nextArg = strtok_r(string, " ", savePtr))) {
         //if the next argument isn't anything, return 0, 
         //which is always out of range
         return 0;
@@ -189,51 +67,86 @@ int next_tok_arg(void) {
     return next;
 }
 
+/*
+ * loads a saved game file, and finds the strings of its stones and which of
+ * them are in atari
+ *
+ * returns 0 on success, or the exit status of the error found (see
+ * error_message())
+ */
+int load_game(struct GameState* game, const char* filename) {
+    int status = load_file(game, filename);
+    if (status) {
+        return status;
+    }
+
+    //check each stone for adjacent stones and find appropriate string IDs
+    game->stringIdCount = 0;
+    for (short row = 0; row < game->height; row++) {
+        for (short column = 0; column < game->width; column++) {
+            if (get_stone(game, row, column) && 
+                    get_stone(game, row, column) != '.') {
+                update_strings(game, row, column);
+            }
+        }
+    }
+    find_ataris(game);
+    return 0;
+}
+
 /*
  * loads the contents of a saved game file into the  game state
+ *
+ * returns 0 on success, or the exit status of the error found (see
+ * error_message())
  */
-void load_file(struct GameState* game, char* filename) {
+int load_file(struct GameState* game, const char* filename) {
 
     FILE* file = fopen(filename, "r");
     if (file == NULL) {
-        quit(4);
+        return 4;
     }
 
     //parse first line of environment variables
     char args[70]; // 70 comfortably covers the longest possible arguments
-    fgets(args, 70, file);
 
     //is there anything there at all?
-    if (!args[0]) {
-        quit(5);
+    if (!fgets(args, 70, file) || !args[0] || parse_first_line(game, args)) {
+        fclose(file);
+        return 5;
     }
 
-    parse_first_line(game, args);
     init_board(game);
 
+    //a row holds width stones, a new line, and the null terminator
+    char* line = malloc(game->width + 2);
+    STAT_COUNT(STAT_ALLOCATIONS, 1);
     for (int i = 0; i < game->height; i++) {
-        if (!fgets(args, game->width + 2, file) ||
-                !update_row(game, i, args)) {
-            quit(5);
+        if (!fgets(line, game->width + 2, file) ||
+                !update_row(game, i, line)) {
+            free(line);
+            fclose(file);
+            return 5;
         }
     }
+    free(line);
     fclose(file);
-
+    return 0;
 }
 
 /*
  * saves the current game state as a file
+ *
+ * returns true iff successful
  */
-void save_game(struct GameState* game, char* filename) {
-
-    //replace the next line character with null
-    int i = 0;
-    while (filename[i] != '\n') {
-        i++;
-    }
-    filename[i] = '\0';
+bool save_game(struct GameState* game, const char* filename) {
+    STAT_TIMER(timer);
 
     FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        STAT_RECORD(STAT_SAVE_GAME, timer);
+        return false;
+    }
 
     fprintf(file, "%d %d %d %d %d %d %d %d %d\n", game->height, game->width, 
             (game->nextPlayer == 'X'), game->nextMoveOY, game->nextMoveOX,
@@ -241,109 +154,74 @@ void save_game(struct GameState* game, char* filename) {
             game->moveCountX);
 
     //print each line of the game's board to file
+    char line[game->width + 1];
     for (int i = 0; i < game->height; i++) {
-        fprintf(file, "%s\n", game->board[i]);
+        copy_row(game, i, line);
+        fprintf(file, "%s\n", line);
     }
-    fclose(file);
-
+    bool saved = (fclose(file) == 0);
+    STAT_RECORD(STAT_SAVE_GAME, timer);
+    return saved;
 }
 
 /* 
  * loads environment variables from a given string
+ *
+ * returns 0 on success, or 5 if the string is invalid (see error_message())
  */
-void parse_first_line(struct GameState* game, char* args) {
+int parse_first_line(struct GameState* game, char* args) {
     int nextArg;
+    char* savePtr;
 
     //height and width, get arguments and convert both to integers
-    int height = strtol(strtok(args, " "), NULL, 10);
-    int width = strtol(strtok(NULL, " "), NULL, 10);
+    int height = next_tok_arg(args, &savePtr);
+    int width = next_tok_arg(NULL, &savePtr);
     if (!in_size_bounds(height, width)) {
-        quit(5);
+        return 5;
     }
     game->height = height;
     game->width = width;
 
     //next player (either 1 or 0)
-    nextArg = next_tok_arg();
+    nextArg = next_tok_arg(NULL, &savePtr);
     if (!nextArg) {
         game->nextPlayer = 'O';
     } else if (nextArg == 1) {
         game->nextPlayer = 'X';
     } else {
-        quit(5);
+        return 5;
     }
 
     //O's next co-ordinates to attempt
     //Make sure both are within the grid bounds
-    if (!on_grid_y(game, game->nextMoveOY = next_tok_arg()) || 
-            !on_grid_x(game, game->nextMoveOX = next_tok_arg())) {
-        quit(5);
+    if (!on_grid_y(game, game->nextMoveOY = next_tok_arg(NULL, &savePtr)) || 
+            !on_grid_x(game, game->nextMoveOX = next_tok_arg(NULL, &savePtr))) {
+        return 5;
     }
 
     //the number of moves O has made
-    nextArg = next_tok_arg();
+    nextArg = next_tok_arg(NULL, &savePtr);
     if (nextArg > height * width / 2 || nextArg < 0) {
-        quit(5); //the number of moves is to small or large for the given board
+        return 5; //the number of moves is to small or large for the board
     }
     game->moveCountO = nextArg;
 
     //X's next co-ordinates to attempt
     //Make sure both are within the grid bounds
-    if (!on_grid_y(game, game->nextMoveXY = next_tok_arg()) || 
-            !on_grid_x(game, game->nextMoveXX = next_tok_arg())) {
-        quit(5);
+    if (!on_grid_y(game, game->nextMoveXY = next_tok_arg(NULL, &savePtr)) || 
+            !on_grid_x(game, game->nextMoveXX = next_tok_arg(NULL, &savePtr))) {
+        return 5;
     }
 
     //the number of moves X has made
-    nextArg = next_tok_arg();
+    nextArg = next_tok_arg(NULL, &savePtr);
     if (nextArg > height * width / 2 || nextArg < 0) {
-        quit(5); //the number of moves is to small or large for the given board
+        return 5; //the number of moves is to small or large for the board
     }
     game->moveCountX = nextArg;
+    return 0;
 }
 
-/*
- * get the appropriate input for the player types
- */
-char* get_input(struct GameState* game, char* input) {
-
-    if (game->nextPlayer == 'X' && game->p2type == 'c') {
-        if (get_stone(game, game->nextMoveXY, game->nextMoveXX) == '.') {
-            //if p2's next given move's square is free, the move is valid
-            sprintf(input, "%d %d\n", game->nextMoveXY, game->nextMoveXX);
-            printf("Player %c: %s", game->nextPlayer, input);
-        } else {
-            input = 0;
-        }
-        next_cpu_move(game);
-
-    } else if (game->nextPlayer == 'O' && game->p1type == 'c') {
-        if (get_stone(game, game->nextMoveOY, game->nextMoveOX) == '.') {
-            //if p1's next given move's square is free, the move is valid
-            sprintf(input, "%d %d\n", game->nextMoveOY, game->nextMoveOX);
-            printf("Player %c: %s", game->nextPlayer, input);
-        } else {
-            input = 0;
-        }
-        next_cpu_move(game);
-
-    } else {
-        printf("Player %c> ", game->nextPlayer); 
-
-        if (!fgets(input, 72, stdin)) {
-            quit(6);
-        }
-        if (feof(stdin)) {
-            quit(6);
-        } else if (strlen(input) > 70) {
-            input = "0";
-            return input;
-        }
-    }
-    return input;
-}
-
-
 /*
  * initialise new game variables as their default values
  */
@@ -361,40 +239,76 @@ void init_game_variables(struct GameState* game) {
 
 
 /*
- * Initialise the go board for the given height and width,
- * and an equivalent two dimensional array for each squares string Id.
- * Populate each with '.'s and 0's respectively
+ * Initialise the go board for the given height and width as a grid of 
+ * unallocated tiles, so every square starts out as '.' with a string ID of 0,
+ * and no strings are in atari.
  *
+ * Tiles are only allocated as stones are placed, so the memory used grows with
+ * the occupied area of the board rather than the size of the board.
  */
-char** init_board(struct GameState* game) {
-
-    int width = game->width;
-    int height = game->height;
-
-    //initialise the board, fill with '.'
-    char** board = malloc(sizeof(char*) * height);
-    short column;
-    for (short row = 0; row < game->height; row++) {
-        board[row] = malloc(sizeof(char) * width + 1); //extra element for '\0'
-        for (column = 0; column < width; column++) {
-            board[row][column] = '.';
+void init_board(struct GameState* game) {
+    game->tileRows = (game->height + TILE_MASK) >> TILE_SHIFT;
+    game->tileColumns = (game->width + TILE_MASK) >> TILE_SHIFT;
+    int tileCount = game->tileRows * game->tileColumns;
+    game->tiles = calloc(tileCount, sizeof(struct Tile*));
+    STAT_COUNT(STAT_ALLOCATIONS, 1);
+    game->stoneCount = 0;
+    game->winner = '\0';
+    init_ataris(game);
+
+    //small boards are nearly always filled, so allocate every tile at once
+    game->tileBlock = NULL;
+    if (tileCount <= SMALL_BOARD_TILES) {
+        game->tileBlock = calloc(tileCount, sizeof(struct Tile));
+        STAT_COUNT(STAT_ALLOCATIONS, 1);
+        for (int i = 0; i < tileCount; i++) {
+            game->tiles[i] = &game->tileBlock[i];
+            init_patterns(game, game->tiles[i],
+                    i / game->tileColumns << TILE_SHIFT,
+                    i % game->tileColumns << TILE_SHIFT);
         }
-        board[row][column] = '\0';
     }
+}
 
-    //initialise the string ID array, fill with 0
-    int** stringIds = malloc(sizeof(int*) * height);
-    for (short row = 0; row < game->height; row++) {
-        stringIds[row] = malloc(sizeof(int) * width);
-        for (column = 0; column < width; column++) {
-            stringIds[row][column] = 0;
+/*
+ * frees the memory used by a game's board, leaving the game state empty
+ */
+void free_game(struct GameState* game) {
+    if (game->tiles) {
+        for (int i = 0; !game->tileBlock &&
+                i < game->tileRows * game->tileColumns; i++) {
+            free(game->tiles[i]);
         }
-    }
-
-    game->board = board;
-    game->stringIds = stringIds;
-    return board;
+        free(game->tiles);
+        game->tiles = NULL;
+    }
+    free(game->tileBlock);
+    game->tileBlock = NULL;
+    for (int i = 0; i < 2; i++) {
+        free(game->ataris[i].strings);
+        game->ataris[i].strings = NULL;
+        game->ataris[i].count = game->ataris[i].capacity = 0;
+    }
+    free(game->floodStack);
+    game->floodStack = NULL;
+    game->floodCapacity = 0;
+}
 
+/*
+ * returns the tile containing the given square, or NULL if it has not been
+ * allocated. If create is true, a missing tile is allocated first.
+ */
+struct Tile* get_tile(struct GameState* game, short row, short column,
+        bool create) {
+    struct Tile** tile = &game->tiles[(row >> TILE_SHIFT) * game->tileColumns
+            + (column >> TILE_SHIFT)];
+    if (!*tile && create) {
+        *tile = calloc(1, sizeof(struct Tile));
+        STAT_COUNT(STAT_ALLOCATIONS, 1);
+        init_patterns(game, *tile, row, column);
+        init_atari_liberties(game, *tile, row, column);
+    }
+    return *tile;
 }
 
 /*
@@ -418,17 +332,124 @@ char get_stone(struct GameState* game, short row, short column) {
     if (!on_grid_y(game, row) || !on_grid_x(game, column)) {
         return '\0';
     }
-    return game->board[row][column];
+    struct Tile* tile = get_tile(game, row, column, false);
+    if (tile) {
+        unsigned short bit = 1 << (column & TILE_MASK);
+        if (tile->stonesX[row & TILE_MASK] & bit) {
+            return 'X';
+        } else if (tile->stonesO[row & TILE_MASK] & bit) {
+            return 'O';
+        }
+    }
+    return '.';
+}
+
+/*
+ * sets the value of a square on the board to 'X', 'O' or '.', updating the
+ * patterns of its neighbours
+ */
+void set_stone(struct GameState* game, short row, short column, char stone) {
+    struct Tile* tile = get_tile(game, row, column, stone != '.');
+    if (!tile) {
+        return; //an unallocated square is already empty
+    }
+    update_patterns(game, row, column, stone);
+
+    unsigned short bit = 1 << (column & TILE_MASK);
+    unsigned short* stonesX = &tile->stonesX[row & TILE_MASK];
+    unsigned short* stonesO = &tile->stonesO[row & TILE_MASK];
+
+    //remove any stone already on the square before placing the new one
+    if ((*stonesX | *stonesO) & bit) {
+        tile->stoneCount--;
+        game->stoneCount--;
+    }
+    *stonesX &= ~bit;
+    *stonesO &= ~bit;
+
+    if (stone == 'X') {
+        *stonesX |= bit;
+    } else if (stone == 'O') {
+        *stonesO |= bit;
+    } else {
+        return;
+    }
+    tile->stoneCount++;
+    game->stoneCount++;
+}
+
+/*
+ * returns the string ID of a square on the board
+ */
+int get_string_id(struct GameState* game, short row, short column) {
+    struct Tile* tile = get_tile(game, row, column, false);
+    if (!tile) {
+        return 0;
+    }
+    return tile->stringIds[row & TILE_MASK][column & TILE_MASK];
+}
+
+/*
+ * sets the string ID of a square on the board
+ */
+void set_string_id(struct GameState* game, short row, short column, int id) {
+    get_tile(game, row, column, true)->
+            stringIds[row & TILE_MASK][column & TILE_MASK] = id;
+}
+
+/*
+ * prepare a cursor to scan the board from the start, see next_stone()
+ */
+void start_scan(struct BoardCursor* cursor) {
+    cursor->tile = 0;
+    cursor->cell = 0;
+}
+
+/*
+ * Move the cursor to the next stone on the board, skipping empty tiles.
+ * Stones are visited a tile at a time, rather than in row order.
+ *
+ * returns true iff another stone was found
+ */
+bool next_stone(struct GameState* game, struct BoardCursor* cursor) {
+    int tileCount = game->tileRows * game->tileColumns;
+
+    for (; cursor->tile < tileCount; cursor->tile++, cursor->cell = 0) {
+        struct Tile* tile = game->tiles[cursor->tile];
+        if (!tile || !tile->stoneCount) {
+            continue;
+        }
+
+        //check what's left of each row of the tile, from the current cell on
+        for (; cursor->cell < TILE_SIZE * TILE_SIZE; 
+                cursor->cell = (cursor->cell | TILE_MASK) + 1) {
+            short tileRow = cursor->cell >> TILE_SHIFT;
+            unsigned int stones = (tile->stonesX[tileRow] | 
+                    tile->stonesO[tileRow]) >> (cursor->cell & TILE_MASK);
+            if (!stones) {
+                continue;
+            }
+            cursor->cell += __builtin_ctz(stones);
+            cursor->row = (cursor->tile / game->tileColumns << TILE_SHIFT) + 
+                    tileRow;
+            cursor->column = (cursor->tile % game->tileColumns << TILE_SHIFT) 
+                    + (cursor->cell & TILE_MASK);
+            cursor->cell++;
+            STAT_COUNT(STAT_CELLS_SCANNED, 1);
+            return true;
+        }
+    }
+    return false;
 }
 
 /*
- * return true iff an adjacent square is empty
+ * copies the stone values of a row of the board into a null terminated string
  */
-bool check_liberties(struct GameState* game, short row, short column) {
-    return square_empty(game, row, column + 1) ||
-            square_empty(game, row, column - 1) ||
-            square_empty(game, row + 1, column) ||
-            square_empty(game, row - 1, column);
+void copy_row(struct GameState* game, short row, char* buffer) {
+    for (short column = 0; column < game->width; column++) {
+        buffer[column] = get_stone(game, row, column);
+    }
+    buffer[game->width] = '\0';
 }
 
 /*
@@ -470,7 +491,7 @@ bool update_row(struct GameState* game, short row, char* values) {
         if (values[i] != 'X' && values[i] != 'O' && values[i] != '.') {
             return false; //invalid value, return false
         }
-        game->board[row][i] = values[i];
+        set_stone(game, row, i, values[i]);
     }
     return strlen(values) == game->width + 1;
 }
@@ -481,12 +502,27 @@ bool update_row(struct GameState* game, short row, char* values) {
  * returns true iff successful
  */
 bool place_stone(struct GameState* game, short row, short column) {
-    if (get_stone(game, row, column) != '.') {
-        return false;
+    STAT_TIMER(timer);
+    bool placed = (get_stone(game, row, column) == '.');
+    if (placed) {
+        set_stone(game, row, column, game->nextPlayer);
     }
+    STAT_RECORD(STAT_PLACE_STONE, timer);
+    return placed;
+}
 
-    game->board[row][column] = game->nextPlayer;
-    return true;
+/*
+ * For a given stone, update the strings of the board, then check whether
+ * any strings have been captured
+ *
+ * returns true iff a string has been captured
+ */
+bool update_strings(struct GameState* game, short row, short column) {
+    STAT_TIMER(timer);
+    join_strings(game, row, column);
+    STAT_RECORD(STAT_UPDATE_STRINGS, timer);
+
+    return check_for_captures(game, row, column);
 }
 
 /*
@@ -494,20 +530,19 @@ bool place_stone(struct GameState* game, short row, short column) {
  * with the lowest string ID of the previous strings. If necessary, create a
  * new string with a new string ID
  */
-bool update_strings(struct GameState* game, short row, short column) {
-    int** stringIds = game->stringIds;
-
+void join_strings(struct GameState* game, short row, short column) {
     int* oldIds = get_adjacent_string_ids(game, row, column);
 
     int oldIdCount = next_adjacent_string(oldIds); //the number of new IDs
     if (oldIdCount == 0) {
         //no adjacent stones exists
-        return check_for_captures(game, row, column);
+        free(oldIds);
+        return;
     }
 
     //the last ID in the list is the smallest, give the given stone its value
     int newId = oldIds[oldIdCount - 1];
-    stringIds[row][column] = newId;
+    set_string_id(game, row, column, newId);
 
     //Any adjacent stones that have a string ID of INT_MAX have no string,
     //give them the new string ID.
@@ -518,29 +553,33 @@ bool update_strings(struct GameState* game, short row, short column) {
 
     //return if there was only 1 string ID, no strings have to be re-ID'd
     if (oldIdCount == 1) {
-        return check_for_captures(game, row, column);
+        free(oldIds);
+        return;
     }
     oldIds[oldIdCount - 1] = 0;
-
-    //iterate over the board, replacing any stringIds in oldIDs with the new 1
-
-    int bigger; //the number of oldIDs the current stringID is bigger than
-    for (short row = 0; row < game->height; row++) {
-        for (short column = 0; column < game->width; column++) {
-            bigger = 0;
-            for (int* id = oldIds; *id > 0 && id < (id + 4); id++) {
-                if (*id == stringIds[row][column]) {
-                    stringIds[row][column] = newId; //replace old id with new
-                } else if (stringIds[row][column] > *id) {
-                    bigger++; //if the id is bigger than old id, increment
-                }
+    STAT_COUNT(STAT_STRINGS_MERGED, oldIdCount - 1);
+
+    //iterate over the stones, replacing any stringIds in oldIDs with the new 1
+    struct BoardCursor cursor;
+    start_scan(&cursor);
+    while (next_stone(game, &cursor)) {
+        int id = get_string_id(game, cursor.row, cursor.column);
+        int bigger = 0; //the number of oldIDs the current ID is bigger than
+        for (int* oldId = oldIds; *oldId > 0 && oldId < oldIds + 4; oldId++) {
+            if (*oldId == id) {
+                bigger = id - newId; //replace old id with new
+                break;
+            } else if (id > *oldId) {
+                bigger++; //if the id is bigger than old id, increment
             }
-            stringIds[row][column] -= bigger;
+        }
+        if (bigger) {
+            set_string_id(game, cursor.row, cursor.column, id - bigger);
         }
     }
-    game->stringIdCount -= oldIdCount; //remove all old IDs from the id count
-    //free(oldIds);
-    return check_for_captures(game, row, column);
+    //remove all old IDs, other than the new one, from the id count
+    game->stringIdCount -= oldIdCount - 1;
+    free(oldIds);
 }
 
 /*
@@ -563,8 +602,8 @@ int next_adjacent_string(int* strings) {
 void replace_int_max(struct GameState* game, short row, short column,
         int new) {
     if (get_stone(game, row, column) && 
-            game->stringIds[row][column] == INT_MAX) {
-        game->stringIds[row][column] = new;
+            get_string_id(game, row, column) == INT_MAX) {
+        set_string_id(game, row, column, new);
     }
 
 }
@@ -579,6 +618,7 @@ int* get_adjacent_string_ids(struct GameState* game, short row, short column) {
 
     char currentStone = get_stone(game, row, column);
     int* oldIds = malloc(sizeof(int) * 4); //there are up to 4 adjacent stones
+    STAT_COUNT(STAT_ALLOCATIONS, 1);
 
     for (int i = 0; i < 4; i++) {
         oldIds[i] = 0; //initialise
@@ -596,14 +636,17 @@ int* get_adjacent_string_ids(struct GameState* game, short row, short column) {
     smallestId = add_string_to_array(game, oldIds, smallestId, currentStone, 
             row - 1, column);
 
+    //if the last ID is INT_MAX, stones without strings were found.
+    //Clear the flag so it can't be mistaken for an ID
+    bool singletonsFound = (oldIds[3] == INT_MAX);
+    oldIds[3] = 0;
+
     //if smallestID is still INT_MAX, no strings were found
     if (smallestId == INT_MAX) {
-        //if the last ID is INT_MAX, stones without strings were found
-        if (oldIds[3] == 0) {
+        if (!singletonsFound) {
             return oldIds; //no stones were found
         }
         //only IDs of 0 were found, generate a new ID for them
-        oldIds[3] = 0;
         smallestId = ++(game->stringIdCount);
     }
 
@@ -624,19 +667,18 @@ int* get_adjacent_string_ids(struct GameState* game, short row, short column) {
 int add_string_to_array(struct GameState* game, int* stones, 
         int smallestId, char currentStone, short row, short column) {
 
-    int** stringIds = game->stringIds;
     int tempId; //the ID of the stone being currently evaluated
 
     //ensure the stones are equivalent
     if (currentStone == get_stone(game, row, column)) {
-        tempId = stringIds[row][column];
+        tempId = get_string_id(game, row, column);
         if (tempId == 0) {
             /* Stone is not part of string. Make the ID either:
                - the smallest (i.e. its intended value),
                - the same as another adjacent stone (so it will be changed), or
                - INT_MAX (which will be checked for manually)
              */
-            stringIds[row][column] = smallestId;
+            set_string_id(game, row, column, smallestId);
             stones[3] = INT_MAX; //set flag, check for surrounding INT_MAX's
 
         } else if (smallestId == INT_MAX) {
@@ -662,117 +704,134 @@ int add_string_to_array(struct GameState* game, int* stones,
 }
 
 /*
- * Iterate over the entire board, checking for captured strings.
- * Return true iff a string has been captured
+ * Update the strings in atari for the stone just placed, and check whether it
+ * has captured a string. Return true iff a string has been captured, in which
+ * case the game's winner is set
  *
- * The meat of this function operated within two loops that frequently
- * have the potential to return, as well as frequently iterate over
- * and modifying an array as part of such checks.
- * As such, it would be unnecessarily messy to separate very specialised checks
- * into separate functions.
+ * Stones are never removed, so a string can only lose its last liberty to a
+ * stone placed there, at which point update_ataris() counts it as dead. This
+ * means the whole board never needs to be searched for captured strings.
+ * Dead strings are only checked for once a stone is placed next to an 
+ * opposing stone, as captures are otherwise impossible.
  *
+ * Before the game starts, the strings of stones being loaded aren't complete
+ * yet, so their ataris are left for find_ataris() to find once all of them
+ * have been placed.
  */
 bool check_for_captures(struct GameState* game, short row, short column) {
-
-    //if the game hasn't started yet, or there isn't anything to be captured
-    if (!game->started || !nearby_opposing_stones(game, row, column)) {
-        return false;
-    }
-
-    short width = game->width, height = game->height;
-    
-    //for every string, keep track of whether or not it's been captured
-    bool* captured = malloc(sizeof(bool) * (game->stringIdCount));
-    char losingStone = 0;
-
-    for (int string = 0; string < game->stringIdCount; string++) {
-        //initialise as captured, no liberties have been found
-        captured[string] = true;
+    STAT_TIMER(timer);
+    if (game->started) {
+        update_ataris(game, row, column);
     }
 
-    //for each square...
-    for (short row = 0; row < height; row++) {
-        for (short column = 0; column < width; column++) {
-
-            if (square_empty(game, row, column)) {
-                continue;
-            }
-
-            //If it is a solitary stone with no liberties, mark as captured
-            if (game->stringIds[row][column] == 0) { 
-                if (!check_liberties(game, row, column)) {
-                    if ((losingStone = get_stone(game, row, column)) !=
-                            game->nextPlayer) {
-                        /* If the captured stone belongs to the opponent, the 
-                        game ends immediately. Otherwise, keep checking to
-                        see if the current player has captured the enemy */
-                        free(captured);
-                        printf("Player %c wins\n", game->nextPlayer);
-                        return true;
-                    }
-                }
-            } else if (check_liberties(game, row, column)) {
-                //if the stone has liberties, mark its string as not captured
-                captured[game->stringIds[row][column] - 1] = false;
-            }
+    //if the game hasn't started yet, or there isn't anything to be captured
+    if (game->started && nearby_opposing_stones(game, row, column)) {
+        char opponent = (game->nextPlayer == 'X') ? 'O' : 'X';
+        if (get_atari_set(game, opponent)->deadCount) {
+            /* If a captured string belongs to the opponent, the current 
+            player wins, even if one of their own strings has also been 
+            captured */
+            game->winner = game->nextPlayer;
+        } else if (get_atari_set(game, game->nextPlayer)->deadCount) {
+            //the current player has doomed himself to defeat
+            game->winner = opponent;
         }
     }
+    STAT_RECORD(STAT_CHECK_FOR_CAPTURES, timer);
+    return game->winner != '\0';
+}
 
-    for (int string = 0; string < game->stringIdCount; string++) {
-        if (captured[string]) {
-            //find the value of the stones featuring the string id
-            for (short row = 0; row < height; row++) {
-                for (short column = 0; column < width; column++) {
-                    if (game->stringIds[row][column] - 1 == string && 
-                            (losingStone = get_stone(game, row, column)) != 
-                            game->nextPlayer) {
-                        /* If the captured stone belongs to the opponent, the 
-                        game ends immediately. Otherwise, keep checking to
-                        see if the current player has captured the enemy */
-                        free(captured);
-                        printf("Player %c wins\n", game->nextPlayer);
-                        return true;
-                    }
-                }
-            }
+/*
+ * prints a string as a JSON string literal
+ */
+void print_json_string(FILE* output, const char* string) {
+    fputc('"', output);
+    for (; *string; string++) {
+        if (*string == '"' || *string == '\\') {
+            fprintf(output, "\\%c", *string);
+        } else if ((unsigned char) *string < ' ') {
+            fprintf(output, "\\u%04x", *string);
+        } else {
+            fputc(*string, output);
         }
     }
+    fputc('"', output);
+}
 
-    //If a losing stone exists, but the current player hasn't claimed a
-    //victory, he has doomed himself to defeat.
-    if (losingStone) {
-        free(captured);
-        if (game->nextPlayer == 'X') {
-            printf("Player O wins\n");
-        } else {
-            printf("Player X wins\n");
-        }
-        return true;
+/*
+ * Gets the current computer player's next move, and generates the move after
+ * it. 
+ *
+ * returns true iff the move's square is free, and so the move is valid
+ */
+bool cpu_move(struct GameState* game, short* row, short* column) {
+    if (game->nextPlayer == 'X') {
+        *row = game->nextMoveXY;
+        *column = game->nextMoveXX;
+    } else {
+        *row = game->nextMoveOY;
+        *column = game->nextMoveOX;
     }
-    free(captured);
-    return false;
+    bool valid = (get_stone(game, *row, *column) == '.');
+    next_cpu_move(game);
+    return valid;
 }
 
 /*
- * prints the current board state to standard output
+ * returns the next number from a splitmix64 sequence, advancing its state
  */
-void draw_board(struct GameState* game) {
+unsigned long long next_random(unsigned long long* state) {
+    unsigned long long result = (*state += 0x9E3779B97F4A7C15ULL);
+    result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+    return result ^ (result >> 31);
+}
 
-    //top border
-    printf("/");
-    for(int i = 1; printf("-"), i < game->width; i++);
-    printf("\\\n");
+/*
+ * Returns the Zobrist key of a stone on a square, mixed from its position and
+ * colour rather than kept in a table, so any board size can be hashed. The
+ * hash of a board is the XOR of the keys of its stones.
+ */
+unsigned long long square_hash(short row, short column, char stone) {
+    unsigned long long state = (unsigned long long) (unsigned short) row << 32
+            | (unsigned short) column << 1 | (stone == 'X');
+    return next_random(&state);
+}
 
-    for (short row = 0; row < game->height; row++) {
-        printf("|%s|\n", game->board[row]);
+/*
+ * Picks an empty square at random for the current player's move.
+ *
+ * returns false if the board is full
+ */
+bool random_move(struct GameState* game, unsigned long long* state,
+        short* row, short* column) {
+    int squares = game->height * game->width;
+    int empty = squares - game->stoneCount;
+    if (empty <= 0) {
+        return false;
     }
 
-    //bottom border
-    printf("\\");
-    for(int i = 1; printf("-"), i < game->width; i++);
-    printf("/\n");
-} 
+    //guess at squares, which nearly always works unless the board is full
+    for (int i = 0; i < 16; i++) {
+        int square = next_random(state) % squares;
+        *row = square / game->width;
+        *column = square % game->width;
+        if (square_empty(game, *row, *column)) {
+            return true;
+        }
+    }
 
+    //otherwise count along to a random empty square
+    int target = next_random(state) % empty;
+    for (*row = 0; *row < game->height; (*row)++) {
+        for (*column = 0; *column < game->width; (*column)++) {
+            if (square_empty(game, *row, *column) && target-- == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
 /*
  * update the next move values appropriately for the next player
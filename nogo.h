@@ -1,5 +1,72 @@
+#include <stdio.h>
 #include <stdbool.h>
 
+/* the board is split into square tiles, TILE_SIZE squares wide */
+#define TILE_SHIFT 4
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define TILE_MASK (TILE_SIZE - 1)
+
+/* boards of up to this many tiles, such as 19x19, have them all allocated
+ * together when the board is made */
+#define SMALL_BOARD_TILES 4
+
+/* 
+ * A block of the board, which is only allocated once a stone is placed in it.
+ * Every square of an unallocated tile is empty, with a string ID of zero.
+ */
+struct Tile {
+    unsigned short stonesX[TILE_SIZE]; //for each row, a bitmap of 'X' stones
+    unsigned short stonesO[TILE_SIZE]; //for each row, a bitmap of 'O' stones
+    int stoneCount; //the number of stones placed in the tile
+    unsigned short visited[TILE_SIZE]; //scratch bitmap for string_liberties()
+
+    /* For each square, stringIDs stores  a number is identifying which string 
+     * a stone is part of, or zero if it is not in a string with any other 
+     * stone.
+     */
+    int stringIds[TILE_SIZE][TILE_SIZE];
+
+    /* the 3x3 pattern code of each square, see patterns.c */
+    unsigned short patterns[TILE_SIZE][TILE_SIZE];
+
+    /* for 'O' and 'X' respectively, the number of the player's strings in
+     * atari whose last liberty is each square
+     */
+    unsigned char atariLiberties[2][TILE_SIZE][TILE_SIZE];
+};
+
+/* the position of a square on the board */
+struct Point {
+    short row;
+    short column;
+};
+
+/* a string with a single liberty left */
+struct Atari {
+    struct Point stone; //any one of the stones in the string
+    struct Point liberty; //the last empty square adjacent to the string
+};
+
+/* 
+ * The strings of one player which are in atari, kept up to date as each
+ * stone is placed. Strings which have lost their last liberty are no longer
+ * in the set, and are only counted.
+ */
+struct AtariSet {
+    struct Atari* strings;
+    int count; //the number of strings in atari
+    int capacity; //the number of strings there is room for
+    int deadCount; //the number of strings with no liberties
+};
+
+/* the position of a scan over every stone on the board, see next_stone() */
+struct BoardCursor {
+    int tile; //the index of the tile being scanned
+    int cell; //the index of the next square to check within the tile
+    short row; //the row of the last stone found
+    short column; //the column of the last stone found
+};
+
 /* a struct containing all the variables related to the game's state */
 struct GameState {
     char p1type; //whether or not player 1 is a [c]omputer or a [h]uman
@@ -8,6 +75,7 @@ struct GameState {
     short width; //the number of horizontal squares on the board
     char nextPlayer; //X or O
     bool started; //false iff the game is being initialised
+    char winner; //the player who has won, or '\0' if the game isn't over
 
     int nextMoveOY; //the next move of player 'O', on the Y axis
     int nextMoveOX; //the next move of player 'O', on the X axis
@@ -16,30 +84,37 @@ struct GameState {
     int nextMoveXX; //the next move of player 'X', on the X axis
     int moveCountX; //the number of moves player 'X' has made
 
-    char** board; //a 2D array, containing the stone values of each square
+    short tileRows; //the number of tiles covering the board vertically
+    short tileColumns; //the number of tiles covering the board horizontally
 
-    /* For each square, stringIDs stores  a number is identifying which string 
-     * a stone is part of, or zero if it is not in a string with any other 
-     * stone.
+    /* a tileRows by tileColumns array of tiles, containing the stones and 
+     * string IDs of each square, or NULL where no stone has been placed
      */
-    int** stringIds;
+    struct Tile** tiles;
+    struct Tile* tileBlock; //the tiles of a small board, or NULL
+    int stoneCount; //the number of stones on the board
     int stringIdCount; //the number of non-zero ID's that exist
 
+    struct AtariSet ataris[2]; //the strings in atari for 'O' and 'X' 
+    struct Point* floodStack; //scratch space for string_liberties()
+    int floodCapacity; //the number of squares floodStack has room for
+
 };
 
-void quit(int exitValue);
-void arg_parse(struct GameState* game, int argc, char** argv);
+const char* error_message(int status);
 void next_player(struct GameState* game);
-void load_file(struct GameState* game, char* filename);
-void save_game(struct GameState* game, char* filename);
-void parse_first_line(struct GameState* game, char* args);
-int next_tok_arg(void);
+int load_game(struct GameState* game, const char* filename);
+int load_file(struct GameState* game, const char* filename);
+bool save_game(struct GameState* game, const char* filename);
+int parse_first_line(struct GameState* game, char* args);
+int next_tok_arg(char* string, char** savePtr);
 bool in_size_bounds(int width, int height);
 
-char* get_input(struct GameState* game, char* input);
-
 void init_game_variables(struct GameState* game);
-char** init_board(struct GameState* game);
+void init_board(struct GameState* game);
+void free_game(struct GameState* game);
+struct Tile* get_tile(struct GameState* game, short row, short column,
+        bool create);
 bool on_grid_x(struct GameState* game, int x);
 bool on_grid_y(struct GameState* game, int y);
 bool check_for_captures(struct GameState* game, short row, short column);
@@ -49,17 +124,59 @@ int* get_adjacent_string_ids(struct GameState* game, short row, short column);
 int add_string_to_array(struct GameState* game, int* stones, 
         int smallestId, char currentStone, short row, short column);
 bool update_strings(struct GameState* game, short row, short column);
+void join_strings(struct GameState* game, short row, short column);
 int next_adjacent_string(int* strings);
 void replace_int_max(struct GameState* game, short row, short column,
         int new);
-void draw_board(struct GameState* game);
+void print_json_string(FILE* output, const char* string);
 char get_stone(struct GameState* game, short row, short column);
+void set_stone(struct GameState* game, short row, short column, char stone);
+int get_string_id(struct GameState* game, short row, short column);
+void set_string_id(struct GameState* game, short row, short column, int id);
+void start_scan(struct BoardCursor* cursor);
+bool next_stone(struct GameState* game, struct BoardCursor* cursor);
+void copy_row(struct GameState* game, short row, char* buffer);
 bool nearby_liberties(struct GameState* game, short row, short column);
 bool nearby_opposing_stones(struct GameState* game, short row, short column);
 bool square_empty(struct GameState* game, short row, short column);
 bool stone_opposing(struct GameState* game, short row, short column);
 
+void init_ataris(struct GameState* game);
+struct AtariSet* get_atari_set(struct GameState* game, char stone);
+struct Atari* get_ataris(struct GameState* game, char stone, int* count);
+bool captures_string(struct GameState* game, short row, short column,
+        char stone);
+int string_liberties(struct GameState* game, short row, short column,
+        struct Point* liberty);
+void update_ataris(struct GameState* game, short row, short column);
+void find_ataris(struct GameState* game);
+void init_atari_liberties(struct GameState* game, struct Tile* tile,
+        short row, short column);
+
+unsigned short compute_pattern(struct GameState* game, short row,
+        short column);
+void init_patterns(struct GameState* game, struct Tile* tile, short row,
+        short column);
+unsigned short get_pattern(struct GameState* game, short row, short column);
+void update_patterns(struct GameState* game, short row, short column,
+        char stone);
+bool move_captures(struct GameState* game, short row, short column,
+        char stone);
+bool move_is_suicide(struct GameState* game, short row, short column,
+        char stone);
+bool move_is_self_atari(struct GameState* game, short row, short column,
+        char stone);
+int pattern_prior(struct GameState* game, short row, short column,
+        char stone);
+bool pattern_move(struct GameState* game, unsigned long long* state,
+        short* row, short* column);
+
 void generate_cpu_move(struct GameState* game, int initialRow, 
         int initialColumn, int* counter, int* nextMoveY, int* nextMoveX, 
         int factor);
 void next_cpu_move(struct GameState* game);
+bool cpu_move(struct GameState* game, short* row, short* column);
+unsigned long long next_random(unsigned long long* state);
+unsigned long long square_hash(short row, short column, char stone);
+bool random_move(struct GameState* game, unsigned long long* state,
+        short* row, short* column);
@@ -0,0 +1,101 @@
+#include <stdio.h>
+
+/*
+ * Generates pattern_tables.h, the lookup tables for 3x3 pattern codes (see
+ * patterns.c), so the tables are built when nogo is compiled.
+ *
+ * Each of the 8 neighbours of a square takes 2 bits of its code: 0 for
+ * empty, 1 for 'X', 2 for 'O', and 3 for off the board. The 4 orthogonal
+ * neighbours, N, E, S and W, take the low byte, followed by the diagonals
+ * NE, SE, SW and NW. Tables are from the view of 'X' moving next.
+ */
+
+#define EMPTY 0
+#define FRIEND 1
+#define OPPONENT 2
+#define EDGE 3
+
+/*
+ * returns the value of the given neighbour in a pattern code
+ */
+int neighbour(int pattern, int direction) {
+    return (pattern >> (direction * 2)) & 3;
+}
+
+/*
+ * returns the number of orthogonal neighbours with the given value
+ */
+int count_orthogonal(int pattern, int value) {
+    int count = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        count += (neighbour(pattern, direction) == value);
+    }
+    return count;
+}
+
+/*
+ * Returns the playout prior of a move, from 0 to 63, judged from its shape
+ * alone. Moves which fill their own last liberty get 0, and lone stones left
+ * with one liberty get 1, though either may be saved by a capture.
+ */
+int prior(int pattern) {
+    int empty = count_orthogonal(pattern, EMPTY);
+    int friends = count_orthogonal(pattern, FRIEND);
+    int opponents = count_orthogonal(pattern, OPPONENT);
+    int edges = count_orthogonal(pattern, EDGE);
+
+    if (empty == 0 && friends == 0) {
+        return 0;
+    } else if (empty == 1 && friends == 0) {
+        return 1;
+    }
+
+    //taking liberties from the opponent wins games, and staying connected
+    //keeps liberties, but the edge of the board takes them away
+    int value = 16 + 6 * opponents + 2 * friends - 3 * edges;
+
+    for (int direction = 0; direction < 4; direction++) {
+        int side = neighbour(pattern, direction);
+        int nextSide = neighbour(pattern, (direction + 1) % 4);
+        int corner = neighbour(pattern, direction + 4); //between the sides
+
+        if (side == FRIEND && nextSide == FRIEND && corner == FRIEND) {
+            value -= 5; //an empty triangle wastes a liberty
+        } else if (side == OPPONENT && nextSide == OPPONENT) {
+            value += 3; //cutting between two opposing stones
+        } else if (corner == OPPONENT && (side == EMPTY ||
+                nextSide == EMPTY)) {
+            value += 1; //approaching an opposing stone diagonally
+        }
+    }
+
+    if (value < 2) {
+        return 2;
+    }
+    return value > 63 ? 63 : value;
+}
+
+int main(void) {
+    printf("/* generated by patgen.c, do not edit */\n\n");
+
+    printf("/* for each orthogonal byte of a pattern, the number of empty,\n"
+            " * friendly and opposing neighbours, from the view of 'X' */\n");
+    printf("static const struct PatternCounts patternCounts[256] = {\n");
+    for (int pattern = 0; pattern < 256; pattern++) {
+        printf("%s{%d, %d, %d},%s", pattern % 6 ? "" : "    ",
+                count_orthogonal(pattern, EMPTY),
+                count_orthogonal(pattern, FRIEND),
+                count_orthogonal(pattern, OPPONENT),
+                pattern % 6 == 5 ? "\n" : " ");
+    }
+    printf("\n};\n\n");
+
+    printf("/* the playout prior of each pattern, from the view of 'X' */\n");
+    printf("static const unsigned char patternPriors[65536] = {\n");
+    for (int pattern = 0; pattern < 65536; pattern++) {
+        printf("%s%d,%s", pattern % 16 ? "" : "    ", prior(pattern),
+                pattern % 16 == 15 ? "\n" : " ");
+    }
+    printf("};\n");
+    return 0;
+}
@@ -0,0 +1,319 @@
+#include <stdlib.h>
+#include "nogo.h"
+
+/* the neighbour counts of the orthogonal byte of a pattern */
+struct PatternCounts {
+    unsigned char empty;
+    unsigned char friends;
+    unsigned char opponents;
+};
+
+#include "pattern_tables.h"
+
+/* the offsets of the 8 neighbours of a square, in the order of their bits in
+ * a pattern: N, E, S, W, then NE, SE, SW, NW. The opposite of a direction is
+ * always direction ^ 2. */
+static const short patternRows[8] = {-1, 0, 1, 0, -1, 1, 1, -1};
+static const short patternColumns[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+
+/*
+ * returns the 2 bit pattern value of a square: 0 empty, 1 'X', 2 'O', or
+ * 3 off the board
+ */
+static unsigned short pattern_value(char stone) {
+    switch (stone) {
+        case 'X':
+            return 1;
+        case 'O':
+            return 2;
+        case '.':
+            return 0;
+    }
+    return 3;
+}
+
+/*
+ * works out the pattern of a square from the board, rather than the
+ * pattern kept up to date in its tile
+ */
+unsigned short compute_pattern(struct GameState* game, short row,
+        short column) {
+    unsigned short pattern = 0;
+    for (int direction = 0; direction < 8; direction++) {
+        pattern |= pattern_value(get_stone(game, row + patternRows[direction],
+                column + patternColumns[direction])) << (direction * 2);
+    }
+    return pattern;
+}
+
+/*
+ * Sets the patterns of a newly allocated tile, whose squares are all empty.
+ * Only squares around the border of the tile can have stones next to them,
+ * in neighbouring tiles, and only squares on the border of the board can be
+ * next to its edges. Every other square keeps the empty pattern, 0.
+ */
+void init_patterns(struct GameState* game, struct Tile* tile, short row,
+        short column) {
+    row &= ~TILE_MASK;
+    column &= ~TILE_MASK;
+    for (short tileRow = 0; tileRow < TILE_SIZE; tileRow++) {
+        short squareRow = row + tileRow;
+        if (squareRow >= game->height) {
+            break;
+        }
+        bool borderRow = tileRow == 0 || tileRow == TILE_MASK ||
+                squareRow == 0 || squareRow == game->height - 1;
+        for (short tileColumn = 0; tileColumn < TILE_SIZE; tileColumn++) {
+            short squareColumn = column + tileColumn;
+            if (squareColumn >= game->width) {
+                break;
+            } else if (borderRow || tileColumn == 0 ||
+                    tileColumn == TILE_MASK || squareColumn == 0 ||
+                    squareColumn == game->width - 1) {
+                tile->patterns[tileRow][tileColumn] = compute_pattern(game,
+                        squareRow, squareColumn);
+            }
+        }
+    }
+}
+
+/*
+ * returns the 3x3 pattern code of a square, see patgen.c for its layout
+ */
+unsigned short get_pattern(struct GameState* game, short row, short column) {
+    struct Tile* tile = get_tile(game, row, column, false);
+    if (!tile) {
+        //stones in neighbouring tiles may still be next to the square
+        return compute_pattern(game, row, column);
+    }
+    return tile->patterns[row & TILE_MASK][column & TILE_MASK];
+}
+
+/*
+ * Updates the patterns of the 8 neighbours of a square whose stone has
+ * changed, which must be in an allocated tile. Only tiles which are already
+ * allocated are kept up to date, as the patterns of a tile are worked out
+ * from the board when it is allocated.
+ */
+void update_patterns(struct GameState* game, short row, short column,
+        char stone) {
+    unsigned short value = pattern_value(stone);
+    short tileRow = row & TILE_MASK;
+    short tileColumn = column & TILE_MASK;
+
+    //away from the border of its tile, every neighbour is in the same tile.
+    //Those off the board are updated too, but their patterns are never read
+    if (tileRow && tileRow != TILE_MASK && tileColumn &&
+            tileColumn != TILE_MASK) {
+        struct Tile* tile = get_tile(game, row, column, false);
+        for (int direction = 0; direction < 8; direction++) {
+            int shift = (direction ^ 2) * 2;
+            unsigned short* pattern = &tile->patterns
+                    [tileRow + patternRows[direction]]
+                    [tileColumn + patternColumns[direction]];
+            *pattern = (*pattern & ~(3 << shift)) | (value << shift);
+        }
+        return;
+    }
+
+    for (int direction = 0; direction < 8; direction++) {
+        short neighbourRow = row + patternRows[direction];
+        short neighbourColumn = column + patternColumns[direction];
+        if (!on_grid_y(game, neighbourRow) ||
+                !on_grid_x(game, neighbourColumn)) {
+            continue;
+        }
+        struct Tile* tile = get_tile(game, neighbourRow, neighbourColumn,
+                false);
+        if (!tile) {
+            continue;
+        }
+
+        //the square is in the opposite direction from its neighbour
+        int shift = (direction ^ 2) * 2;
+        unsigned short* pattern = &tile->patterns[neighbourRow & TILE_MASK]
+                [neighbourColumn & TILE_MASK];
+        *pattern = (*pattern & ~(3 << shift)) | (value << shift);
+    }
+}
+
+/*
+ * returns a pattern as seen by the given player, swapping 'X' and 'O' if the
+ * player is 'O', as the tables are from the view of 'X'
+ */
+static unsigned short pattern_for(unsigned short pattern, char stone) {
+    if (stone == 'X') {
+        return pattern;
+    }
+    //a neighbour is 1 or 2 iff its bits differ, flip both bits of those
+    return pattern ^ (((pattern ^ (pattern >> 1)) & 0x5555) * 3);
+}
+
+/*
+ * returns the number of strings of a player in atari whose last liberty is
+ * the given square, searching the atari set if its tile isn't allocated
+ */
+static int atari_liberty_count(struct GameState* game, short row,
+        short column, char stone) {
+    struct Tile* tile = get_tile(game, row, column, false);
+    if (tile) {
+        return tile->atariLiberties[stone == 'X'][row & TILE_MASK]
+                [column & TILE_MASK];
+    }
+    int count, found = 0;
+    struct Atari* ataris = get_ataris(game, stone, &count);
+    for (int i = 0; i < count; i++) {
+        found += (ataris[i].liberty.row == row &&
+                ataris[i].liberty.column == column);
+    }
+    return found;
+}
+
+/*
+ * returns true iff the given stone placed on an empty square would take the
+ * last liberty of an opposing string
+ */
+bool move_captures(struct GameState* game, short row, short column,
+        char stone) {
+    unsigned short pattern = pattern_for(get_pattern(game, row, column),
+            stone);
+    char opponent = (stone == 'X') ? 'O' : 'X';
+    return patternCounts[pattern & 0xFF].opponents &&
+            atari_liberty_count(game, row, column, opponent);
+}
+
+/*
+ * Returns the number of different strings of the given player next to a
+ * square. Only needed when a move might join strings in atari.
+ */
+static int adjacent_string_count(struct GameState* game, short row,
+        short column, char stone) {
+    int ids[4];
+    int count = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        short adjacentRow = row + patternRows[direction];
+        short adjacentColumn = column + patternColumns[direction];
+        if (get_stone(game, adjacentRow, adjacentColumn) != stone) {
+            continue;
+        }
+        int id = get_string_id(game, adjacentRow, adjacentColumn);
+        bool counted = false;
+        for (int i = 0; i < count && id; i++) {
+            counted |= (ids[i] == id);
+        }
+        if (!counted) {
+            ids[count++] = id; //stones with ID 0 are always on their own
+        }
+    }
+    return count;
+}
+
+/*
+ * Returns the number of liberties the given stone would have once placed on
+ * an empty square, if it doesn't capture, when that can be told from its
+ * pattern and the atari sets: 0 or 1, or 2 for two or more. Returns -1 if
+ * the stone would join a string with two or more liberties, other than this
+ * square, while having fewer than two liberties of its own.
+ */
+static int liberties_after(struct GameState* game, short row, short column,
+        char stone) {
+    struct PatternCounts counts = patternCounts[pattern_for(
+            get_pattern(game, row, column), stone) & 0xFF];
+    if (counts.empty >= 2) {
+        return 2;
+    } else if (!counts.friends) {
+        return counts.empty;
+    }
+
+    //strings in atari here lose their last liberty by joining the stone
+    int ataris = atari_liberty_count(game, row, column, stone);
+    if (ataris && ataris == adjacent_string_count(game, row, column, stone)) {
+        return counts.empty;
+    }
+    return -1;
+}
+
+/*
+ * returns true iff the given stone placed on an empty square would leave its
+ * string without liberties, without capturing
+ */
+bool move_is_suicide(struct GameState* game, short row, short column,
+        char stone) {
+    return liberties_after(game, row, column, stone) == 0 &&
+            !move_captures(game, row, column, stone);
+}
+
+/*
+ * Returns true iff the given stone placed on an empty square would leave its
+ * string in atari, without capturing. Moves joining a string with two
+ * liberties may be missed, as the pattern can't tell if they're shared.
+ */
+bool move_is_self_atari(struct GameState* game, short row, short column,
+        char stone) {
+    return liberties_after(game, row, column, stone) == 1 &&
+            !move_captures(game, row, column, stone);
+}
+
+/*
+ * returns the playout prior of the given stone on an empty square, from 0 to
+ * 63, from the pattern tables
+ */
+int pattern_prior(struct GameState* game, short row, short column,
+        char stone) {
+    return patternPriors[pattern_for(get_pattern(game, row, column), stone)];
+}
+
+/*
+ * Picks the current player's next move for a playout: a capture if there is
+ * one, otherwise saving a string in atari, otherwise the best of a handful
+ * of random empty squares by their pattern priors, avoiding suicide and
+ * self-atari.
+ *
+ * returns false if the board is full
+ */
+bool pattern_move(struct GameState* game, unsigned long long* state,
+        short* row, short* column) {
+    char stone = game->nextPlayer;
+    char opponent = (stone == 'X') ? 'O' : 'X';
+    int count;
+
+    //capturing wins the game outright
+    struct Atari* ataris = get_ataris(game, opponent, &count);
+    if (count) {
+        *row = ataris[0].liberty.row;
+        *column = ataris[0].liberty.column;
+        return true;
+    }
+
+    //extend a string in atari, if that gives it more liberties
+    ataris = get_ataris(game, stone, &count);
+    for (int i = 0; i < count; i++) {
+        short libertyRow = ataris[i].liberty.row;
+        short libertyColumn = ataris[i].liberty.column;
+        if (liberties_after(game, libertyRow, libertyColumn, stone) >= 2) {
+            *row = libertyRow;
+            *column = libertyColumn;
+            return true;
+        }
+    }
+
+    int bestPrior = -1;
+    for (int i = 0; i < 8; i++) {
+        short candidateRow, candidateColumn;
+        if (!random_move(game, state, &candidateRow, &candidateColumn)) {
+            return false;
+        }
+        int prior = pattern_prior(game, candidateRow, candidateColumn, stone);
+        if (move_is_suicide(game, candidateRow, candidateColumn, stone) ||
+                move_is_self_atari(game, candidateRow, candidateColumn,
+                stone)) {
+            prior = 0;
+        }
+        if (prior > bestPrior) {
+            bestPrior = prior;
+            *row = candidateRow;
+            *column = candidateColumn;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#include <pthread.h>
+#include <unistd.h>
+#include "pool.h"
+
+/* the jobs shared between the threads of a call to run_jobs() */
+struct Pool {
+    int jobCount; //the number of jobs to run
+    int nextJob; //the index of the next job to be taken by a thread
+    JobFunction run;
+    void* arg; //passed along to each job
+};
+
+/*
+ * returns the number of threads to use when none have been asked for
+ */
+int default_thread_count(void) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? processors : 1;
+}
+
+/*
+ * takes jobs from the pool until there are none left
+ */
+static void* run_worker(void* data) {
+    struct Pool* pool = data;
+    int job;
+    while ((job = __atomic_fetch_add(&pool->nextJob, 1, __ATOMIC_RELAXED)) <
+            pool->jobCount) {
+        pool->run(pool->arg, job);
+    }
+    return NULL;
+}
+
+/*
+ * Runs jobs 0 to jobCount - 1 across a number of threads, returning once
+ * every job has finished. Jobs are handed out in order as threads free up.
+ */
+void run_jobs(int jobCount, int threadCount, JobFunction run, void* arg) {
+    struct Pool pool = {jobCount, 0, run, arg};
+
+    if (threadCount > jobCount) {
+        threadCount = jobCount;
+    }
+    if (threadCount <= 1) {
+        run_worker(&pool); //no need for any more threads
+        return;
+    }
+
+    pthread_t threads[threadCount];
+    int started = 0;
+    while (started < threadCount && 
+            !pthread_create(&threads[started], NULL, run_worker, &pool)) {
+        started++;
+    }
+    if (started == 0) {
+        run_worker(&pool); //threads are unavailable, run the jobs here
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
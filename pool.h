@@ -0,0 +1,5 @@
+/* a job run by run_jobs(), given the shared argument and the job's index */
+typedef void (*JobFunction)(void* arg, int job);
+
+int default_thread_count(void);
+void run_jobs(int jobCount, int threadCount, JobFunction run, void* arg);
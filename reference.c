@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include <limits.h>
+#include "reference.h"
+
+/*
+ * The reference engine: nogo's original string and capture algorithms,
+ * scanning the whole board, frozen as the definition of correct behaviour.
+ * It has diverged from the original nogo.c in its state and names, and in
+ * the fixes to its string ID bookkeeping, without which it was wrong (see
+ * the README).
+ *
+ * Don't optimise this file. Optimise the engine, then check it against this
+ * with nogo-diff.
+ */
+
+static bool ref_check_for_captures(struct RefGame* game, short row,
+        short column);
+static int* ref_get_adjacent_string_ids(struct RefGame* game, short row,
+        short column);
+static int ref_add_string_to_array(struct RefGame* game, int* stones,
+        int smallestId, char currentStone, short row, short column);
+static void ref_generate_cpu_move(struct RefGame* game, int initialRow,
+        int initialColumn, int* counter, int* nextMoveY, int* nextMoveX,
+        int factor);
+
+/*
+ * Initialise a new game for the given height and width, with default
+ * variables, and a board of '.'s and string IDs of 0
+ */
+void ref_init_game(struct RefGame* game, short height, short width) {
+    game->height = height;
+    game->width = width;
+    game->nextPlayer = 'O';
+    game->started = false;
+    game->winner = '\0';
+    game->nextMoveOY = 1;
+    game->nextMoveOX = 4 % width;
+    game->moveCountO = 0;
+    game->nextMoveXY = 2;
+    game->nextMoveXX = 10 % width;
+    game->moveCountX = 0;
+    game->stringIdCount = 0;
+
+    game->board = malloc(sizeof(char*) * height);
+    game->stringIds = malloc(sizeof(int*) * height);
+    for (short row = 0; row < height; row++) {
+        game->board[row] = malloc(sizeof(char) * width + 1);
+        game->stringIds[row] = malloc(sizeof(int) * width);
+        for (short column = 0; column < width; column++) {
+            game->board[row][column] = '.';
+            game->stringIds[row][column] = 0;
+        }
+        game->board[row][width] = '\0';
+    }
+}
+
+/*
+ * frees the memory used by a game's board
+ */
+void ref_free_game(struct RefGame* game) {
+    for (short row = 0; row < game->height; row++) {
+        free(game->board[row]);
+        free(game->stringIds[row]);
+    }
+    free(game->board);
+    free(game->stringIds);
+}
+
+/*
+ * changes the next player value to the next player
+ */
+void ref_next_player(struct RefGame* game) {
+    game->nextPlayer = (game->nextPlayer == 'X') ? 'O' : 'X';
+}
+
+/*
+ * returns the value of a stone, or null if it does not exists
+ */
+char ref_get_stone(struct RefGame* game, short row, short column) {
+    if (row < 0 || row >= game->height || column < 0 ||
+            column >= game->width) {
+        return '\0';
+    }
+    return game->board[row][column];
+}
+
+/*
+ * return true iff a square is empty
+ */
+static bool ref_square_empty(struct RefGame* game, short row, short column) {
+    return (ref_get_stone(game, row, column) == '.');
+}
+
+/*
+ * return true iff an adjacent square is empty
+ */
+static bool ref_check_liberties(struct RefGame* game, short row,
+        short column) {
+    return ref_square_empty(game, row, column + 1) ||
+            ref_square_empty(game, row, column - 1) ||
+            ref_square_empty(game, row + 1, column) ||
+            ref_square_empty(game, row - 1, column);
+}
+
+/*
+ * return true iff a square contains a stone opposite to the current player
+ */
+static bool ref_stone_opposing(struct RefGame* game, short row,
+        short column) {
+    char stone = ref_get_stone(game, row, column);
+    return (stone == 'X' || stone == 'O') && stone != game->nextPlayer;
+}
+
+/*
+ * returns true if there is the opposite stone in the surrounding area
+ */
+static bool ref_nearby_opposing_stones(struct RefGame* game, short row,
+        short column) {
+    return ref_stone_opposing(game, row, column + 1) ||
+            ref_stone_opposing(game, row, column - 1) ||
+            ref_stone_opposing(game, row + 1, column) ||
+            ref_stone_opposing(game, row - 1, column);
+}
+
+/*
+ * place the next player's stone on a square if it's empty
+ *
+ * returns true iff successful
+ */
+bool ref_place_stone(struct RefGame* game, short row, short column) {
+    if (ref_get_stone(game, row, column) != '.') {
+        return false;
+    }
+    game->board[row][column] = game->nextPlayer;
+    return true;
+}
+
+/*
+ * returns first unused element in the string of adjacent squares,
+ * or 4 if they are all used
+ */
+static int ref_next_adjacent_string(int* strings) {
+    for (int i = 0; i < 4; i++) {
+        if (strings[i] == 0) {
+            return i;
+        }
+    }
+    return 4;
+}
+
+/*
+ * replaces an INT_MAX value in a given square with the given value
+ */
+static void ref_replace_int_max(struct RefGame* game, short row,
+        short column, int new) {
+    if (ref_get_stone(game, row, column) &&
+            game->stringIds[row][column] == INT_MAX) {
+        game->stringIds[row][column] = new;
+    }
+}
+
+/*
+ * For a given stone, combine any adjacent strings to form a single string,
+ * with the lowest string ID of the previous strings. If necessary, create a
+ * new string with a new string ID. Then check the board for captures.
+ *
+ * returns true iff a string has been captured
+ */
+bool ref_update_strings(struct RefGame* game, short row, short column) {
+    int** stringIds = game->stringIds;
+
+    int* oldIds = ref_get_adjacent_string_ids(game, row, column);
+
+    int oldIdCount = ref_next_adjacent_string(oldIds);
+    if (oldIdCount == 0) {
+        //no adjacent stones exists
+        free(oldIds);
+        return ref_check_for_captures(game, row, column);
+    }
+
+    //the last ID in the list is the smallest, give the given stone its value
+    int newId = oldIds[oldIdCount - 1];
+    stringIds[row][column] = newId;
+
+    //Any adjacent stones that have a string ID of INT_MAX have no string,
+    //give them the new string ID.
+    ref_replace_int_max(game, row, column - 1, newId);
+    ref_replace_int_max(game, row, column + 1, newId);
+    ref_replace_int_max(game, row - 1, column, newId);
+    ref_replace_int_max(game, row + 1, column, newId);
+
+    //return if there was only 1 string ID, no strings have to be re-ID'd
+    if (oldIdCount == 1) {
+        free(oldIds);
+        return ref_check_for_captures(game, row, column);
+    }
+    oldIds[oldIdCount - 1] = 0;
+
+    //iterate over the board, replacing any stringIds in oldIDs with the new 1
+    for (short row = 0; row < game->height; row++) {
+        for (short column = 0; column < game->width; column++) {
+            int id = stringIds[row][column];
+            int bigger = 0; //the number of oldIDs the ID is bigger than
+            for (int i = 0; i < 4 && oldIds[i] > 0; i++) {
+                if (oldIds[i] == id) {
+                    bigger = id - newId; //replace old id with new
+                    break;
+                } else if (id > oldIds[i]) {
+                    bigger++;
+                }
+            }
+            stringIds[row][column] -= bigger;
+        }
+    }
+    game->stringIdCount -= oldIdCount - 1;
+    free(oldIds);
+    return ref_check_for_captures(game, row, column);
+}
+
+/*
+ * returns an array containing the string ids of all equivalently valued
+ * adjacent strings, with the smallest Id at the end
+ *
+ * all unused elements are 0
+ */
+static int* ref_get_adjacent_string_ids(struct RefGame* game, short row,
+        short column) {
+
+    char currentStone = ref_get_stone(game, row, column);
+    int* oldIds = calloc(4, sizeof(int)); //there are up to 4 adjacent stones
+    int smallestId = INT_MAX;
+
+    //for each adjacent square, add its string ID to the array
+    smallestId = ref_add_string_to_array(game, oldIds, smallestId,
+            currentStone, row, column + 1);
+    smallestId = ref_add_string_to_array(game, oldIds, smallestId,
+            currentStone, row, column - 1);
+    smallestId = ref_add_string_to_array(game, oldIds, smallestId,
+            currentStone, row + 1, column);
+    smallestId = ref_add_string_to_array(game, oldIds, smallestId,
+            currentStone, row - 1, column);
+
+    //if the last ID is INT_MAX, stones without strings were found
+    bool singletonsFound = (oldIds[3] == INT_MAX);
+    oldIds[3] = 0;
+
+    //if smallestID is still INT_MAX, no strings were found
+    if (smallestId == INT_MAX) {
+        if (!singletonsFound) {
+            return oldIds; //no stones were found
+        }
+        //only IDs of 0 were found, generate a new ID for them
+        smallestId = ++(game->stringIdCount);
+    }
+
+    //Append the smallest ID to the end
+    oldIds[ref_next_adjacent_string(oldIds)] = smallestId;
+    return oldIds;
+}
+
+/*
+ * Add the stringId of a given square, or smallestID to an array, whichever is
+ * larger. Return the other value.
+ */
+static int ref_add_string_to_array(struct RefGame* game, int* stones,
+        int smallestId, char currentStone, short row, short column) {
+
+    int** stringIds = game->stringIds;
+    int tempId; //the ID of the stone being currently evaluated
+
+    //ensure the stones are equivalent
+    if (currentStone == ref_get_stone(game, row, column)) {
+        tempId = stringIds[row][column];
+        if (tempId == 0) {
+            //Stone is not part of string, flag it for checking
+            stringIds[row][column] = smallestId;
+            stones[3] = INT_MAX;
+
+        } else if (smallestId == INT_MAX) {
+            smallestId = tempId; //No strings have been found yet
+
+        } else if (smallestId > tempId) {
+            stones[ref_next_adjacent_string(stones)] = smallestId;
+            smallestId = tempId;
+
+        } else if (smallestId < tempId) {
+            //if the ID is already in the list, don't add it again
+            for (int* id = stones; *id != 0; id++) {
+                if (tempId == *id) {
+                    return smallestId;
+                }
+            }
+            stones[ref_next_adjacent_string(stones)] = tempId;
+        }
+    }
+
+    return smallestId;
+}
+
+/*
+ * Iterate over the entire board, checking for captured strings.
+ * Return true iff a string has been captured, setting the winner
+ */
+static bool ref_check_for_captures(struct RefGame* game, short row,
+        short column) {
+
+    //if the game hasn't started yet, or there isn't anything to be captured
+    if (!game->started || !ref_nearby_opposing_stones(game, row, column)) {
+        return false;
+    }
+
+    //for every string, keep track of whether or not it's been captured
+    bool* captured = malloc(sizeof(bool) * (game->stringIdCount + 1));
+    char losingStone = 0;
+
+    for (int string = 0; string < game->stringIdCount; string++) {
+        //initialise as captured, no liberties have been found
+        captured[string] = true;
+    }
+
+    //for each square...
+    for (short row = 0; row < game->height; row++) {
+        for (short column = 0; column < game->width; column++) {
+
+            if (ref_square_empty(game, row, column)) {
+                continue;
+            }
+
+            //If it is a solitary stone with no liberties, mark as captured
+            if (game->stringIds[row][column] == 0) {
+                if (!ref_check_liberties(game, row, column) &&
+                        (losingStone = ref_get_stone(game, row, column)) !=
+                        game->nextPlayer) {
+                    free(captured);
+                    game->winner = game->nextPlayer;
+                    return true;
+                }
+            } else if (ref_check_liberties(game, row, column)) {
+                //if the stone has liberties, mark its string as not captured
+                captured[game->stringIds[row][column] - 1] = false;
+            }
+        }
+    }
+
+    for (int string = 0; string < game->stringIdCount; string++) {
+        if (!captured[string]) {
+            continue;
+        }
+        //find the value of the stones featuring the string id
+        for (short row = 0; row < game->height; row++) {
+            for (short column = 0; column < game->width; column++) {
+                if (game->stringIds[row][column] - 1 == string &&
+                        (losingStone = ref_get_stone(game, row, column)) !=
+                        game->nextPlayer) {
+                    free(captured);
+                    game->winner = game->nextPlayer;
+                    return true;
+                }
+            }
+        }
+    }
+    free(captured);
+
+    //If a losing stone exists, but the current player hasn't claimed a
+    //victory, he has doomed himself to defeat.
+    if (losingStone) {
+        game->winner = (game->nextPlayer == 'X') ? 'O' : 'X';
+        return true;
+    }
+    return false;
+}
+
+/*
+ * update the next move values appropriately for the next player
+ */
+void ref_next_cpu_move(struct RefGame* game) {
+    int initialRow, initialColumn;
+    int* counter, *nextMoveX, *nextMoveY;
+    int factor;
+
+    //apply player-specific variables for move generation algorithm
+    if (game->nextPlayer == 'X') {
+        counter = &(game->moveCountX);
+        initialRow = 2;
+        initialColumn = 10;
+        nextMoveX = &game->nextMoveXX;
+        nextMoveY = &game->nextMoveXY;
+        factor = 17;
+    } else {
+        counter = &(game->moveCountO);
+        initialRow = 1;
+        initialColumn = 4;
+        nextMoveX = &game->nextMoveOX;
+        nextMoveY = &game->nextMoveOY;
+        factor = 29;
+    }
+
+    do {
+        ref_generate_cpu_move(game, initialRow, initialColumn, counter,
+                nextMoveY, nextMoveX, factor);
+    } while (!ref_square_empty(game, *nextMoveY, *nextMoveX));
+}
+
+/*
+ * Generate the a game move for the given parameters
+ */
+static void ref_generate_cpu_move(struct RefGame* game, int initialRow,
+        int initialColumn, int* counter, int* nextMoveY, int* nextMoveX,
+        int factor) {
+
+    int temp;
+    (*counter)++;
+
+    switch (*counter % 5) {
+        case 0:
+            temp = (initialRow * game->width + initialColumn);
+            temp = (temp + *counter / 5 * factor) % 1000003;
+            *nextMoveY = (temp / game->width);
+            *nextMoveX = (temp % game->width);
+            break;
+        case 1:
+            (*nextMoveX)++;
+            (*nextMoveY)++;
+            break;
+        case 2:
+            (*nextMoveX)++;
+            (*nextMoveY) += 2;
+            break;
+        case 3:
+            (*nextMoveY)++;
+            break;
+        case 4:
+            (*nextMoveX)++;
+    }
+
+    //ensure next moves are on the same grid
+    *nextMoveY %= game->height;
+    *nextMoveX %= game->width;
+}
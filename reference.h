@@ -0,0 +1,38 @@
+#include <stdbool.h>
+
+/*
+ * The state of a game played by the reference engine, which keeps the
+ * original full board representation and algorithms of nogo, for checking
+ * optimised versions of the engine against (see diff.c).
+ */
+struct RefGame {
+    short height; //the number of vertical squares on the board
+    short width; //the number of horizontal squares on the board
+    char nextPlayer; //X or O
+    bool started; //false iff the game is being initialised
+    char winner; //the player who has won, or '\0' if the game isn't over
+
+    int nextMoveOY; //the next move of player 'O', on the Y axis
+    int nextMoveOX; //the next move of player 'O', on the X axis
+    int moveCountO; //the number of moves player 'O' has made
+    int nextMoveXY; //the next move of player 'X', on the Y axis
+    int nextMoveXX; //the next move of player 'X', on the X axis
+    int moveCountX; //the number of moves player 'X' has made
+
+    char** board; //a 2D array, containing the stone values of each square
+
+    /* For each square, stringIDs stores  a number is identifying which string
+     * a stone is part of, or zero if it is not in a string with any other
+     * stone.
+     */
+    int** stringIds;
+    int stringIdCount; //the number of non-zero ID's that exist
+};
+
+void ref_init_game(struct RefGame* game, short height, short width);
+void ref_free_game(struct RefGame* game);
+void ref_next_player(struct RefGame* game);
+char ref_get_stone(struct RefGame* game, short row, short column);
+bool ref_place_stone(struct RefGame* game, short row, short column);
+bool ref_update_strings(struct RefGame* game, short row, short column);
+void ref_next_cpu_move(struct RefGame* game);
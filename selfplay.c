@@ -0,0 +1,496 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "nogo.h"
+#include "pool.h"
+#include "compress.h"
+
+/*
+ * Plays games of the computer player against itself across a pool of
+ * threads, writing every position, the move played from it and the winner
+ * of its game to a binary stream, for training evaluators on.
+ *
+ * The stream starts with a StreamHeader, followed by blocks, each a
+ * BlockHeader and the block's records, which may be compressed (see
+ * compress.c). Every record is a whole game: a GameHeader, then for each
+ * position the board packed 2 bits to a square in row order, 4 to a byte
+ * from the low bits up, as 0 for empty, 1 for 'X' and 2 for 'O', followed by
+ * the row and column of the move played, as 2 byte integers. Players take
+ * turns from the game's first player. Integers are in the byte order of the
+ * machine the stream was written on.
+ *
+ * The computer player is deterministic, so a game is played again exactly
+ * by nogo-selfplay -n 1 with its header's board size, seed and opening
+ * moves.
+ *
+ * Workers fill blocks and compress them, and a single writer thread writes
+ * them out in the order they are finished, so games are not in order. Only
+ * QUEUE_BLOCKS blocks can wait for the writer, after which workers wait for
+ * the disk to catch up rather than using more memory.
+ */
+
+#define STREAM_MAGIC "NOGOPLAY"
+#define STREAM_VERSION 2
+
+/* the size a worker's block grows to before being written */
+#define BLOCK_SIZE (1 << 20)
+
+/* the number of finished blocks that can wait to be written */
+#define QUEUE_BLOCKS 16
+
+/* set in the flags of a block whose records are compressed */
+#define BLOCK_COMPRESSED 1
+
+/* the start of a stream */
+struct StreamHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int unused;
+};
+
+/* the start of a block of records */
+struct BlockHeader {
+    unsigned int rawSize; //the size of the block's records
+    unsigned int storedSize; //the size of the block as written
+    unsigned int flags;
+};
+
+/* the start of the record of a game */
+struct GameHeader {
+    unsigned short height; //the number of vertical squares on the board
+    unsigned short width; //the number of horizontal squares on the board
+    unsigned int positionCount; //the number of positions which follow
+    char firstPlayer; //the player who moves from the first position
+    char winner; //the player who won, or '\0' if the board filled up
+    unsigned short unused;
+    unsigned int openingMoves; //the number of random moves the game opened with
+    unsigned long long seed; //the seed of its opening, to replay the game from
+};
+
+/* records being gathered into a block */
+struct Records {
+    unsigned char* data;
+    size_t size; //the number of bytes used
+    size_t capacity; //the number of bytes allocated
+};
+
+/* blocks waiting for the writer thread, see write_blocks() */
+struct BlockQueue {
+    struct BlockHeader headers[QUEUE_BLOCKS];
+    unsigned char* blocks[QUEUE_BLOCKS];
+    int first; //the index of the oldest block
+    int count; //the number of blocks waiting
+    bool finished; //true once no more blocks will be added
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+};
+
+/* the settings and progress of a run of self-play games */
+struct SelfPlay {
+    short height; //the height of every board
+    short width; //the width of every board
+    int games; //the number of games to play
+    int nextGame; //the index of the next game to be taken by a worker
+    unsigned long long seed; //game n plays its opening from seed + n
+    int openingMoves; //the number of random moves each game opens with
+    bool compress; //whether blocks are compressed
+
+    FILE* output;
+    struct BlockQueue queue;
+    unsigned long long positions; //the number of positions recorded
+    unsigned long long bytes; //the number of bytes written
+    bool failed; //true if writing to the output failed
+};
+
+/*
+ * makes room for size more bytes of records, returning where they go
+ */
+static unsigned char* reserve(struct Records* records, size_t size) {
+    if (records->size + size > records->capacity) {
+        while (records->size + size > records->capacity) {
+            records->capacity *= 2;
+        }
+        records->data = realloc(records->data, records->capacity);
+    }
+    unsigned char* place = records->data + records->size;
+    records->size += size;
+    return place;
+}
+
+/*
+ * Plays one game, adding its record. The game opens with random moves from
+ * its seed, so each game differs, and the computer player finishes it.
+ */
+static void play_game(struct SelfPlay* run, int index,
+        struct Records* records) {
+    struct GameState game;
+    memset(&game, 0, sizeof(struct GameState));
+    game.p1type = game.p2type = 'c';
+    game.height = run->height;
+    game.width = run->width;
+    init_game_variables(&game);
+    init_board(&game);
+    game.started = true;
+
+    int squares = game.height * game.width;
+    int boardSize = (squares + 3) / 4;
+    unsigned char board[boardSize];
+    memset(board, 0, boardSize);
+
+    size_t headerPlace = records->size;
+    reserve(records, sizeof(struct GameHeader));
+    struct GameHeader header;
+    memset(&header, 0, sizeof(struct GameHeader));
+    header.height = game.height;
+    header.width = game.width;
+    header.firstPlayer = game.nextPlayer;
+    header.openingMoves = run->openingMoves;
+    header.seed = run->seed + index;
+
+    unsigned long long random = header.seed;
+    short row, column;
+    while (game.stoneCount < squares) {
+        if (header.positionCount < run->openingMoves) {
+            random_move(&game, &random, &row, &column);
+        } else if (!cpu_move(&game, &row, &column)) {
+            continue; //the computer's square was taken, try its next one
+        }
+
+        unsigned char* place = reserve(records, boardSize + 2 *
+                sizeof(short));
+        memcpy(place, board, boardSize);
+        memcpy(place + boardSize, &row, sizeof(short));
+        memcpy(place + boardSize + sizeof(short), &column, sizeof(short));
+        header.positionCount++;
+
+        place_stone(&game, row, column);
+        int square = row * game.width + column;
+        board[square >> 2] |= (game.nextPlayer == 'X' ? 1 : 2) <<
+                ((square & 3) * 2);
+        if (update_strings(&game, row, column)) {
+            break;
+        }
+        next_player(&game);
+    }
+
+    header.winner = game.winner;
+    memcpy(records->data + headerPlace, &header, sizeof(struct GameHeader));
+    __atomic_fetch_add(&run->positions, header.positionCount,
+            __ATOMIC_RELAXED);
+    free_game(&game);
+}
+
+/*
+ * Compresses a worker's block if asked to, and hands it to the writer,
+ * waiting while the queue is full. The records are given up to the queue,
+ * and replaced with an empty block.
+ */
+static void queue_block(struct SelfPlay* run, struct Records* records) {
+    struct BlockHeader header = {records->size, records->size, 0};
+    unsigned char* block = records->data;
+    if (run->compress) {
+        unsigned char* compressed = malloc(compress_bound(records->size));
+        size_t size = compress_block(records->data, records->size,
+                compressed);
+        if (size < records->size) {
+            header.storedSize = size;
+            header.flags |= BLOCK_COMPRESSED;
+            block = compressed;
+            free(records->data);
+        } else {
+            free(compressed);
+        }
+    }
+
+    struct BlockQueue* queue = &run->queue;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == QUEUE_BLOCKS) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+    }
+    int slot = (queue->first + queue->count++) % QUEUE_BLOCKS;
+    queue->headers[slot] = header;
+    queue->blocks[slot] = block;
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+
+    records->data = malloc(BLOCK_SIZE);
+    records->size = 0;
+    records->capacity = BLOCK_SIZE;
+}
+
+/*
+ * Plays games until there are none left, gathering their records into
+ * blocks. Each worker is a job of the pool, with a block of its own.
+ */
+static void run_worker(void* arg, int job) {
+    struct SelfPlay* run = arg;
+    struct Records records = {malloc(BLOCK_SIZE), 0, BLOCK_SIZE};
+
+    int game;
+    while ((game = __atomic_fetch_add(&run->nextGame, 1, __ATOMIC_RELAXED))
+            < run->games) {
+        play_game(run, game, &records);
+        if (records.size >= BLOCK_SIZE) {
+            queue_block(run, &records);
+        }
+    }
+    if (records.size) {
+        queue_block(run, &records);
+    }
+    free(records.data);
+}
+
+/*
+ * The writer thread, which writes out blocks as they are queued, until the
+ * queue is finished and empty. Blocks are still taken from the queue after
+ * a failed write, so workers never wait on it.
+ */
+static void* write_blocks(void* arg) {
+    struct SelfPlay* run = arg;
+    struct BlockQueue* queue = &run->queue;
+
+    while (true) {
+        pthread_mutex_lock(&queue->lock);
+        while (!queue->count && !queue->finished) {
+            pthread_cond_wait(&queue->notEmpty, &queue->lock);
+        }
+        if (!queue->count) {
+            pthread_mutex_unlock(&queue->lock);
+            return NULL;
+        }
+        struct BlockHeader header = queue->headers[queue->first];
+        unsigned char* block = queue->blocks[queue->first];
+        queue->first = (queue->first + 1) % QUEUE_BLOCKS;
+        queue->count--;
+        pthread_cond_signal(&queue->notFull);
+        pthread_mutex_unlock(&queue->lock);
+
+        if (!run->failed && (fwrite(&header, sizeof(struct BlockHeader), 1,
+                run->output) != 1 || fwrite(block, 1, header.storedSize,
+                run->output) != header.storedSize)) {
+            run->failed = true;
+        }
+        run->bytes += sizeof(struct BlockHeader) + header.storedSize;
+        free(block);
+    }
+}
+
+/*
+ * Plays a run of games, writing their records to its output.
+ *
+ * returns false if the output couldn't be written
+ */
+static bool self_play(struct SelfPlay* run, int threads) {
+    struct StreamHeader header;
+    memset(&header, 0, sizeof(struct StreamHeader));
+    memcpy(header.magic, STREAM_MAGIC, sizeof(header.magic));
+    header.version = STREAM_VERSION;
+    if (fwrite(&header, sizeof(struct StreamHeader), 1, run->output) != 1) {
+        return false;
+    }
+    run->bytes = sizeof(struct StreamHeader);
+
+    struct BlockQueue* queue = &run->queue;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, write_blocks, run)) {
+        return false;
+    }
+
+    run_jobs(threads, threads, run_worker, run);
+
+    pthread_mutex_lock(&queue->lock);
+    queue->finished = true;
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(writer, NULL);
+
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_cond_destroy(&queue->notFull);
+    return !run->failed;
+}
+
+/*
+ * prints the games of a block of records as text
+ *
+ * returns false if the records are cut short
+ */
+static bool print_records(unsigned char* records, size_t size) {
+    unsigned char* end = records + size;
+    while (records < end) {
+        struct GameHeader header;
+        if ((size_t) (end - records) < sizeof(struct GameHeader)) {
+            return false;
+        }
+        memcpy(&header, records, sizeof(struct GameHeader));
+        records += sizeof(struct GameHeader);
+        printf("game %dx%d, %u positions, winner %c, seed %llu, "
+                "%u opening moves\n", header.height, header.width,
+                header.positionCount, header.winner ? header.winner : '-',
+                header.seed, header.openingMoves);
+
+        int squares = header.height * header.width;
+        size_t positionSize = (squares + 3) / 4 + 2 * sizeof(short);
+        if ((size_t) (end - records) / positionSize < header.positionCount) {
+            return false;
+        }
+        char player = header.firstPlayer;
+        for (unsigned int i = 0; i < header.positionCount; i++) {
+            for (int square = 0; square < squares; square++) {
+                int value = (records[square >> 2] >> ((square & 3) * 2)) & 3;
+                if (square && square % header.width == 0) {
+                    putchar('/');
+                }
+                putchar(".XO?"[value]);
+            }
+            short row, column;
+            memcpy(&row, records + positionSize - 2 * sizeof(short),
+                    sizeof(short));
+            memcpy(&column, records + positionSize - sizeof(short),
+                    sizeof(short));
+            printf(" %c %d %d\n", player, row, column);
+            player = (player == 'X') ? 'O' : 'X';
+            records += positionSize;
+        }
+    }
+    return true;
+}
+
+/*
+ * prints every game of a stream as text, one line per position
+ *
+ * returns false if the stream is invalid
+ */
+static bool print_stream(FILE* input) {
+    struct StreamHeader header;
+    if (fread(&header, sizeof(struct StreamHeader), 1, input) != 1 ||
+            memcmp(header.magic, STREAM_MAGIC, sizeof(header.magic)) ||
+            header.version != STREAM_VERSION) {
+        return false;
+    }
+
+    struct BlockHeader block;
+    while (fread(&block, sizeof(struct BlockHeader), 1, input) == 1) {
+        unsigned char* stored = malloc(block.storedSize);
+        unsigned char* records = stored;
+        bool valid = stored && (fread(stored, 1, block.storedSize, input) ==
+                block.storedSize);
+        if (valid && (block.flags & BLOCK_COMPRESSED)) {
+            records = malloc(block.rawSize);
+            valid = records && decompress_block(stored, block.storedSize,
+                    records, block.rawSize);
+        } else if (block.rawSize != block.storedSize) {
+            valid = false;
+        }
+        valid = valid && print_records(records, block.rawSize);
+        if (records != stored) {
+            free(records);
+        }
+        free(stored);
+        if (!valid) {
+            return false;
+        }
+    }
+    return feof(input);
+}
+
+/*
+ * returns the current time in seconds
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int threads = default_thread_count();
+    struct SelfPlay run;
+    memset(&run, 0, sizeof(struct SelfPlay));
+    run.games = 1000;
+    run.seed = 1;
+    run.height = run.width = 9;
+    run.openingMoves = 4;
+    bool decode = false;
+    int height = run.height, width = run.width;
+
+    int option;
+    while ((option = getopt(argc, argv, "j:n:s:H:W:o:zd")) != -1) {
+        switch (option) {
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'n':
+                run.games = atoi(optarg);
+                break;
+            case 's':
+                run.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'H':
+                height = atoi(optarg);
+                break;
+            case 'W':
+                width = atoi(optarg);
+                break;
+            case 'o':
+                run.openingMoves = atoi(optarg);
+                break;
+            case 'z':
+                run.compress = true;
+                break;
+            case 'd':
+                decode = true;
+                break;
+            default:
+                threads = 0;
+        }
+    }
+    if (optind != argc - 1 || threads < 1 || run.games < 1 ||
+            run.openingMoves < 0 || !in_size_bounds(height, width)) {
+        fprintf(stderr, "Usage: nogo-selfplay [-j threads] [-n games] "
+                "[-s seed] [-H height] [-W width] [-o opening] [-z] output\n"
+                "       nogo-selfplay -d input\n");
+        return 1;
+    }
+    run.height = height;
+    run.width = width;
+
+    char* filename = argv[optind];
+    bool standard = !strcmp(filename, "-");
+    if (decode) {
+        FILE* input = standard ? stdin : fopen(filename, "rb");
+        if (!input) {
+            fprintf(stderr, "%s\n", error_message(4));
+            return 4;
+        } else if (!print_stream(input)) {
+            fprintf(stderr, "%s\n", error_message(5));
+            return 5;
+        }
+        return 0;
+    }
+
+    run.output = standard ? stdout : fopen(filename, "wb");
+    if (!run.output) {
+        fprintf(stderr, "%s\n", error_message(4));
+        return 4;
+    }
+    double start = now();
+    bool written = self_play(&run, threads);
+    written = !fclose(run.output) && written;
+    double elapsed = now() - start;
+    fprintf(stderr, "games %d, positions %llu, bytes %llu, %.0f positions/s\n",
+            run.games, run.positions, run.bytes,
+            elapsed > 0 ? run.positions / elapsed : 0);
+    if (!written) {
+        fprintf(stderr, "Unable to write to %s\n", filename);
+        return 4;
+    }
+    return 0;
+}
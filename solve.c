@@ -0,0 +1,563 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nogo.h"
+#include "solve.h"
+#include "cache.h"
+
+/*
+ * An exact solver for small boards. Positions are kept as a bitmap of each
+ * player's stones, a bit per square, so moves can be made and unmade by
+ * flipping a bit. The solver plays by the engine's rules: a move next to an
+ * opposing stone wins if any opposing string has no liberties, and otherwise
+ * loses if any of the mover's strings has none. A full board is a draw.
+ */
+
+/* the largest number of squares the solver can handle, a bit for each */
+#define MAX_SOLVE_SQUARES 64
+
+/* the transposition table has room for 2^squares positions, within these
+ * bounds, so a 4x4 board needs 1.5 MB and 5x5 or larger boards 100 MB */
+#define MIN_TABLE_BITS 12
+#define MAX_TABLE_BITS 22
+
+/* the depth stored for a value which didn't depend on the search horizon */
+#define SOLVED_DEPTH 127
+
+/* the number of moves from the position being solved within which the
+ * position cache is used, where positions are most often shared by games */
+#define CACHE_PLIES 4
+
+/* mixed into the hash of positions with 'X' to move */
+#define SIDE_HASH 0x6A09E667F3BCC909ULL
+
+/* how a value stored in the transposition table bounds the true value */
+enum Bound {
+    BOUND_EXACT,
+    BOUND_LOWER,
+    BOUND_UPPER
+};
+
+/* a searched position, in its canonical orientation */
+struct SolveEntry {
+    unsigned long long stones[2]; //the 'O' and 'X' stones
+    signed char side; //the player to move, 0 for 'O' or 1 for 'X'
+    signed char value; //1, 0 or -1 for a win, draw or loss of the side to move
+    signed char bound; //see enum Bound
+    signed char depth; //the depth searched to, or 0 if the entry is unused
+    signed char move; //the best move found, or -1
+};
+
+/* the state of a search over a small board */
+struct Solver {
+    short height; //the number of vertical squares on the board
+    short width; //the number of horizontal squares on the board
+    unsigned long long board; //a bit for every square of the board
+    unsigned long long leftColumn; //a bit for every square of column 0
+    unsigned long long rightColumn; //a bit for every square of the last column
+
+    /* the board's symmetries, 8 for a square board or 4 otherwise, as the
+     * square each square is moved to, and back again, and the Zobrist keys
+     * of each stone moved by each symmetry (see square_hash())
+     */
+    int symmetryCount;
+    unsigned char squareMap[8][MAX_SOLVE_SQUARES];
+    unsigned char squareUnmap[8][MAX_SOLVE_SQUARES];
+    unsigned long long squareHashes[8][MAX_SOLVE_SQUARES][2];
+
+    unsigned long long stones[2]; //the 'O' and 'X' stones
+    unsigned long long hashes[8]; //the hash of the stones under each symmetry
+    int side; //the player to move, 0 for 'O' or 1 for 'X'
+    int ply; //the number of moves made since the position being solved
+
+    struct SolveEntry* table; //buckets of two entries, see find_entry()
+    unsigned long long tableMask; //the number of entries in the table, less 1
+    struct PositionCache* cache; //solved positions from earlier runs, or NULL
+    long long nodes; //the number of positions searched
+    long long horizons; //the number of times the search horizon was reached
+    long long cacheHits; //the number of positions found in the cache
+};
+
+/*
+ * returns the squares next to any of the given squares
+ */
+static unsigned long long neighbours(struct Solver* solver,
+        unsigned long long squares) {
+    return (((squares << 1) & ~solver->leftColumn) |
+            ((squares >> 1) & ~solver->rightColumn) |
+            (squares << solver->width) | (squares >> solver->width)) &
+            solver->board;
+}
+
+/* the strings of both players which decide the next move */
+struct StringSummary {
+    unsigned long long ataris[2]; //the last liberties of strings in atari
+    unsigned long long pressed[2]; //the liberties of strings with two left
+    bool dead[2]; //whether each player has a string with no liberties
+};
+
+/*
+ * returns the string of a player's stones containing a square
+ */
+static unsigned long long string_at(struct Solver* solver, int square,
+        unsigned long long stones) {
+    unsigned long long string = 1ULL << square;
+    unsigned long long grown;
+    while ((grown = string | (neighbours(solver, string) & stones)) !=
+            string) {
+        string = grown;
+    }
+    return string;
+}
+
+/*
+ * finds the strings of both players which are in atari or dead
+ */
+static void summarise_strings(struct Solver* solver,
+        struct StringSummary* summary) {
+    unsigned long long empty = solver->board &
+            ~(solver->stones[0] | solver->stones[1]);
+    for (int side = 0; side < 2; side++) {
+        summary->ataris[side] = summary->pressed[side] = 0;
+        summary->dead[side] = false;
+        unsigned long long remaining = solver->stones[side];
+        while (remaining) {
+            unsigned long long string = string_at(solver,
+                    __builtin_ctzll(remaining), solver->stones[side]);
+            unsigned long long liberties = neighbours(solver, string) & empty;
+            remaining &= ~string;
+            if (!liberties) {
+                summary->dead[side] = true;
+            } else if (__builtin_popcountll(liberties) == 1) {
+                summary->ataris[side] |= liberties;
+            } else if (__builtin_popcountll(liberties) == 2) {
+                summary->pressed[side] |= liberties;
+            }
+        }
+    }
+}
+
+/*
+ * Returns the empty squares a player would win the game by playing on. Only
+ * moves next to an opposing stone check for captures, and then any opposing
+ * string without liberties wins, whether or not the move took its last one.
+ */
+static unsigned long long winning_squares(struct Solver* solver,
+        struct StringSummary* summary, int side) {
+    unsigned long long empty = solver->board &
+            ~(solver->stones[0] | solver->stones[1]);
+    unsigned long long targets = summary->dead[!side] ? empty :
+            summary->ataris[!side];
+    return targets & empty & neighbours(solver, solver->stones[!side]);
+}
+
+/*
+ * Returns the empty squares a player would lose the game by playing on, from
+ * those that don't win it: next to an opposing stone, with one of their own
+ * strings left without liberties.
+ */
+static unsigned long long losing_squares(struct Solver* solver,
+        struct StringSummary* summary, int side) {
+    unsigned long long empty = solver->board &
+            ~(solver->stones[0] | solver->stones[1]);
+    unsigned long long checked = empty &
+            neighbours(solver, solver->stones[!side]);
+    if (summary->dead[side]) {
+        return checked;
+    }
+
+    //otherwise only a stone with no empty neighbours can lose its liberties
+    unsigned long long losing = 0;
+    for (unsigned long long squares = checked & ~neighbours(solver, empty);
+            squares; squares &= squares - 1) {
+        int square = __builtin_ctzll(squares);
+        unsigned long long string = string_at(solver, square,
+                solver->stones[side] | (1ULL << square));
+        if (!(neighbours(solver, string) & empty & ~(1ULL << square))) {
+            losing |= 1ULL << square;
+        }
+    }
+    return losing;
+}
+
+/*
+ * adds or removes a player's stone, keeping the hashes up to date
+ */
+static void flip_stone(struct Solver* solver, int square, int side) {
+    solver->stones[side] ^= 1ULL << square;
+    for (int i = 0; i < solver->symmetryCount; i++) {
+        solver->hashes[i] ^= solver->squareHashes[i][square][side];
+    }
+}
+
+/*
+ * plays the next player's stone on an empty square
+ */
+static void make_move(struct Solver* solver, int square) {
+    flip_stone(solver, square, solver->side);
+    solver->side ^= 1;
+    solver->ply++;
+}
+
+/*
+ * takes back the last move made, on the given square
+ */
+static void unmake_move(struct Solver* solver, int square) {
+    solver->ply--;
+    solver->side ^= 1;
+    flip_stone(solver, square, solver->side);
+}
+
+/*
+ * returns the given squares moved by one of the board's symmetries
+ */
+static unsigned long long transform(struct Solver* solver, int symmetry,
+        unsigned long long squares) {
+    unsigned long long result = 0;
+    for (; squares; squares &= squares - 1) {
+        result |= 1ULL << solver->squareMap[symmetry]
+                [__builtin_ctzll(squares)];
+    }
+    return result;
+}
+
+/*
+ * Finds the transposition table entry for the current position. Every
+ * symmetry of a position shares the entry of the orientation with the lowest
+ * hash, which is given by symmetry. The entry's stones are checked, rather
+ * than trusting the hash alone.
+ *
+ * A position may be in either entry of its bucket. If it isn't found, entry
+ * is the one to replace: the first if it was searched no deeper than depth,
+ * so deep results survive, or else the second.
+ *
+ * returns true iff the entry holds the position
+ */
+static bool find_entry(struct Solver* solver, int depth,
+        struct SolveEntry** entry, int* symmetry,
+        unsigned long long stones[2]) {
+    *symmetry = 0;
+    for (int i = 1; i < solver->symmetryCount; i++) {
+        if (solver->hashes[i] < solver->hashes[*symmetry]) {
+            *symmetry = i;
+        }
+    }
+    unsigned long long hash = solver->hashes[*symmetry] ^
+            (solver->side ? SIDE_HASH : 0);
+    struct SolveEntry* bucket = &solver->table[hash & solver->tableMask & ~1];
+
+    stones[0] = transform(solver, *symmetry, solver->stones[0]);
+    stones[1] = transform(solver, *symmetry, solver->stones[1]);
+    for (int i = 0; i < 2; i++) {
+        *entry = &bucket[i];
+        if ((*entry)->depth && (*entry)->side == solver->side &&
+                (*entry)->stones[0] == stones[0] &&
+                (*entry)->stones[1] == stones[1]) {
+            return true;
+        }
+    }
+    *entry = &bucket[bucket[0].depth > depth];
+    return false;
+}
+
+/*
+ * fills in the position cache entry for a canonical position
+ */
+static void cache_position(struct Solver* solver, struct CacheEntry* position,
+        unsigned long long stones[2]) {
+    position->stones[0] = stones[0];
+    position->stones[1] = stones[1];
+    position->height = solver->height;
+    position->width = solver->width;
+    position->side = solver->side;
+}
+
+/*
+ * Searches the current position to the given number of moves with
+ * alpha-beta pruning, setting bestMove to the best square found, or -1 if
+ * the board is full.
+ *
+ * returns 1, 0 or -1 if the player to move wins, draws or loses. A position
+ * which isn't decided within the horizon counts as a draw, and adds to the
+ * solver's count of horizons reached.
+ */
+static int search(struct Solver* solver, int depth, int alpha, int beta,
+        int* bestMove) {
+    int side = solver->side;
+    unsigned long long empty = solver->board &
+            ~(solver->stones[0] | solver->stones[1]);
+    solver->nodes++;
+    *bestMove = -1;
+
+    if (!empty) {
+        return 0;
+    } else if (!depth) {
+        solver->horizons++;
+        return 0;
+    }
+
+    struct SolveEntry* entry;
+    int symmetry;
+    unsigned long long stones[2];
+    int tableMove = -1;
+    if (find_entry(solver, depth, &entry, &symmetry, stones)) {
+        int value = entry->value;
+        tableMove = solver->squareUnmap[symmetry][(int) entry->move];
+        bool decided = (value == 1 && entry->bound != BOUND_UPPER) ||
+                (value == -1 && entry->bound != BOUND_LOWER);
+        if ((decided || entry->depth >= depth) &&
+                (entry->bound == BOUND_EXACT ||
+                (entry->bound == BOUND_LOWER && value >= beta) ||
+                (entry->bound == BOUND_UPPER && value <= alpha))) {
+            if (!decided && entry->depth != SOLVED_DEPTH) {
+                solver->horizons++; //the value came from a shallower search
+            }
+            *bestMove = tableMove;
+            return value;
+        }
+    }
+
+    //positions near the start may have been solved by an earlier run
+    struct CacheEntry position;
+    bool cached = solver->cache && solver->ply < CACHE_PLIES;
+    if (cached) {
+        cache_position(solver, &position, stones);
+        if (cache_probe(solver->cache, &position)) {
+            solver->cacheHits++;
+            *bestMove = (position.move < 0) ? -1 :
+                    solver->squareUnmap[symmetry][(int) position.move];
+            return position.value;
+        }
+    }
+
+    //take a win if there is one, and find the squares the opponent would
+    //win on next move, as any other move loses to them
+    struct StringSummary summary;
+    summarise_strings(solver, &summary);
+    unsigned long long wins = winning_squares(solver, &summary, side);
+    if (wins) {
+        *bestMove = __builtin_ctzll(wins);
+        return 1;
+    }
+    unsigned long long losing = losing_squares(solver, &summary, side);
+    unsigned long long threats = winning_squares(solver, &summary, !side);
+    if (__builtin_popcountll(threats) > 1) {
+        *bestMove = __builtin_ctzll(threats);
+        return -1;
+    }
+
+    //try the best move from an earlier search first, then moves putting an
+    //opposing string in atari, then the other squares next to stones, where
+    //the game is decided, and moves that lose last
+    unsigned long long moves = threats ? threats : empty;
+    int order[MAX_SOLVE_SQUARES];
+    int count = 0;
+    if (tableMove >= 0 && (moves & (1ULL << tableMove))) {
+        order[count++] = tableMove;
+        moves &= ~(1ULL << tableMove);
+    }
+    unsigned long long groups[4];
+    groups[0] = moves & ~losing & summary.pressed[!side];
+    groups[1] = moves & ~losing & ~groups[0] & neighbours(solver,
+            solver->stones[0] | solver->stones[1]);
+    groups[2] = moves & ~losing & ~groups[0] & ~groups[1];
+    groups[3] = moves & losing;
+    for (int group = 0; group < 4; group++) {
+        for (; groups[group]; groups[group] &= groups[group] - 1) {
+            order[count++] = __builtin_ctzll(groups[group]);
+        }
+    }
+
+    int originalAlpha = alpha;
+    long long horizons = solver->horizons;
+    int best = -2;
+    for (int i = 0; i < count && alpha < beta; i++) {
+        int value = -1;
+        if (!(losing & (1ULL << order[i]))) {
+            int reply;
+            make_move(solver, order[i]);
+            value = -search(solver, depth - 1, -beta, -alpha, &reply);
+            unmake_move(solver, order[i]);
+        }
+        if (value > best) {
+            best = value;
+            *bestMove = order[i];
+        }
+        if (best > alpha) {
+            alpha = best;
+        }
+    }
+
+    entry->stones[0] = stones[0];
+    entry->stones[1] = stones[1];
+    entry->side = side;
+    entry->value = best;
+    entry->bound = (best <= originalAlpha) ? BOUND_UPPER :
+            (best >= beta) ? BOUND_LOWER : BOUND_EXACT;
+    entry->depth = (solver->horizons == horizons) ? SOLVED_DEPTH : depth;
+    entry->move = solver->squareMap[symmetry][*bestMove];
+
+    //only exact values are cached, as the window depends on the search, and
+    //draws only if they didn't depend on the horizon
+    bool exact = entry->bound == BOUND_EXACT || (best == 1 &&
+            entry->bound == BOUND_LOWER) || (best == -1 &&
+            entry->bound == BOUND_UPPER);
+    if (cached && exact && (best || entry->depth == SOLVED_DEPTH)) {
+        position.value = best;
+        position.move = entry->move;
+        cache_store(solver->cache, &position);
+    }
+    return best;
+}
+
+/*
+ * sets up the solver's board, symmetries and stones from a game
+ */
+static void init_solver(struct Solver* solver, struct GameState* game) {
+    memset(solver, 0, sizeof(struct Solver));
+    short height = solver->height = game->height;
+    short width = solver->width = game->width;
+    int squares = height * width;
+    solver->board = (squares == 64) ? ~0ULL : (1ULL << squares) - 1;
+    for (short row = 0; row < height; row++) {
+        solver->leftColumn |= 1ULL << (row * width);
+        solver->rightColumn |= 1ULL << (row * width + width - 1);
+    }
+
+    //reflections and rotations, though only square boards can be turned a
+    //quarter turn or reflected across a diagonal
+    solver->symmetryCount = (height == width) ? 8 : 4;
+    for (int symmetry = 0; symmetry < solver->symmetryCount; symmetry++) {
+        for (short row = 0; row < height; row++) {
+            for (short column = 0; column < width; column++) {
+                short newRow = (symmetry & 1) ? height - 1 - row : row;
+                short newColumn = (symmetry & 2) ? width - 1 - column : column;
+                if (symmetry & 4) {
+                    short swap = newRow;
+                    newRow = newColumn;
+                    newColumn = swap;
+                }
+                int square = row * width + column;
+                int newSquare = newRow * width + newColumn;
+                solver->squareMap[symmetry][square] = newSquare;
+                solver->squareUnmap[symmetry][newSquare] = square;
+                solver->squareHashes[symmetry][square][0] =
+                        square_hash(newRow, newColumn, 'O');
+                solver->squareHashes[symmetry][square][1] =
+                        square_hash(newRow, newColumn, 'X');
+            }
+        }
+    }
+
+    for (short row = 0; row < height; row++) {
+        for (short column = 0; column < width; column++) {
+            char stone = get_stone(game, row, column);
+            if (stone != '.') {
+                flip_stone(solver, row * width + column, stone == 'X');
+            }
+        }
+    }
+    solver->side = (game->nextPlayer == 'X');
+    int tableBits = squares;
+    if (tableBits < MIN_TABLE_BITS) {
+        tableBits = MIN_TABLE_BITS;
+    } else if (tableBits > MAX_TABLE_BITS) {
+        tableBits = MAX_TABLE_BITS;
+    }
+    solver->tableMask = (1ULL << tableBits) - 1;
+    solver->table = calloc(solver->tableMask + 1, sizeof(struct SolveEntry));
+}
+
+/*
+ * Solves a game with iterative deepening, printing the progress of each
+ * depth, then the result and best move for the player to move. Each depth
+ * orders its moves from the transposition table left by the last. Positions
+ * near the start are looked up in the cache, if given, and added once solved.
+ */
+static void solve(struct GameState* game, struct PositionCache* cache) {
+    struct Solver solver;
+    init_solver(&solver, game);
+    solver.cache = cache;
+
+    int value, move;
+    for (int depth = 1; ; depth++) {
+        long long horizons = solver.horizons;
+        value = search(&solver, depth, -1, 1, &move);
+        bool solved = (value || solver.horizons == horizons);
+        printf("Depth %d: %s, %lld positions\n", depth,
+                solved ? "solved" : "unknown", solver.nodes);
+        if (solved) {
+            break;
+        }
+    }
+
+    char opponent = (game->nextPlayer == 'X') ? 'O' : 'X';
+    if (value) {
+        printf("Player %c wins\n", (value > 0) ? game->nextPlayer : opponent);
+    } else {
+        printf("Draw\n");
+    }
+    if (move >= 0) {
+        printf("Best move: %d %d\n", move / game->width, move % game->width);
+    }
+    if (solver.cacheHits) {
+        printf("%lld positions found in the cache\n", solver.cacheHits);
+    }
+    free(solver.table);
+}
+
+/*
+ * Runs the solver for the arguments after --solve, either a board size to
+ * solve from the start, or a saved game
+ *
+ * returns the exit status of nogo
+ */
+int solve_main(int argc, char** argv) {
+    struct GameState game;
+    memset(&game, 0, sizeof(struct GameState));
+    int status = 0;
+    char* validIntCheck; //to see if strtol returns valid numbers
+
+    if (argc == 2) {
+        status = load_game(&game, argv[1]);
+    } else if (argc == 3) {
+        int height = strtol(argv[1], &validIntCheck, 10);
+        int width = 0;
+        if (!*validIntCheck) {
+            width = strtol(argv[2], &validIntCheck, 10);
+        }
+        if (*validIntCheck || !in_size_bounds(height, width)) {
+            status = 3;
+        } else {
+            game.height = height;
+            game.width = width;
+            init_game_variables(&game);
+            init_board(&game);
+        }
+    } else {
+        fprintf(stderr, "Usage: nogo --solve [height width | filename]\n");
+        return 1;
+    }
+
+    if (!status && game.height * game.width > MAX_SOLVE_SQUARES) {
+        status = 3; //too large to solve
+    }
+    if (status) {
+        fprintf(stderr, "%s\n", error_message(status));
+    } else {
+        //solved positions are shared between runs through the file named by
+        //the NOGO_CACHE environment variable
+        struct PositionCache cache;
+        char* cacheName = getenv("NOGO_CACHE");
+        bool cached = cacheName && *cacheName;
+        if (cached && !(cached = open_cache(&cache, cacheName))) {
+            fprintf(stderr, "Unable to open cache %s\n", cacheName);
+        }
+        solve(&game, cached ? &cache : NULL);
+        if (cached) {
+            close_cache(&cache);
+        }
+    }
+    free_game(&game);
+    return status;
+}
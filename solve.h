@@ -0,0 +1 @@
+int solve_main(int argc, char** argv);
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include "stats.h"
+
+/* 
+ * Latencies are recorded in HDR-style log-linear buckets: values are grouped
+ * by their highest set bit, and each group split into SUB_BUCKETS, so every 
+ * bucket is within 1 / SUB_BUCKETS of its value.
+ */
+#define SUB_BUCKET_BITS 3
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define BUCKETS (64 * SUB_BUCKETS)
+
+/* the recorded latencies of a phase, in nanoseconds */
+struct Histogram {
+    unsigned long long counts[BUCKETS];
+    unsigned long long count; //the number of latencies recorded
+    unsigned long long total; //the sum of every latency
+    unsigned long long min; //ULLONG_MAX until a latency is recorded
+    unsigned long long max;
+};
+
+static const char* phaseNames[STAT_PHASES] = {"get_input", "place_stone",
+        "update_strings", "check_for_captures", "draw_board", "save_game"};
+static const char* counterNames[STAT_COUNTERS] = {"cells_scanned",
+        "strings_merged", "allocations"};
+
+/* the statistics are shared by every thread, so are updated atomically */
+static bool enabled;
+static const char* reportName; //where to write the report
+static struct Histogram histograms[STAT_PHASES];
+static unsigned long long counters[STAT_COUNTERS];
+
+#ifdef NOGO_STATS
+/*
+ * turns statistics on at startup if the NOGO_STATS environment variable is
+ * set, reporting them at exit
+ */
+__attribute__((constructor)) static void init_stats(void) {
+    reportName = getenv("NOGO_STATS");
+    if (reportName && *reportName && strcmp(reportName, "0")) {
+        enabled = true;
+        for (int i = 0; i < STAT_PHASES; i++) {
+            histograms[i].min = ULLONG_MAX;
+        }
+        atexit(write_stats);
+    }
+}
+#endif
+
+/*
+ * returns the current time in nanoseconds, to start timing a phase, or 0 if
+ * statistics are turned off
+ */
+long long stat_clock(void) {
+    if (!enabled) {
+        return 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * returns the bucket a latency is recorded in
+ */
+static int bucket_index(unsigned long long value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+/*
+ * returns the largest latency recorded in a bucket
+ */
+static unsigned long long bucket_value(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    unsigned long long lowest = 
+            (unsigned long long) (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+/*
+ * records the time taken by a phase, since start was taken from stat_clock()
+ */
+void stat_record(enum StatPhase phase, long long start) {
+    if (!enabled || !start) {
+        return;
+    }
+    unsigned long long latency = stat_clock() - start;
+    struct Histogram* histogram = &histograms[phase];
+
+    __atomic_fetch_add(&histogram->counts[bucket_index(latency)], 1,
+            __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->total, latency, __ATOMIC_RELAXED);
+
+    unsigned long long max = __atomic_load_n(&histogram->max, 
+            __ATOMIC_RELAXED);
+    while (latency > max && !__atomic_compare_exchange_n(&histogram->max,
+            &max, latency, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    unsigned long long min = __atomic_load_n(&histogram->min,
+            __ATOMIC_RELAXED);
+    while (latency < min && !__atomic_compare_exchange_n(&histogram->min,
+            &min, latency, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/*
+ * adds an amount to one of the counters
+ */
+void stat_count(enum StatCounter counter, long long amount) {
+    if (enabled) {
+        __atomic_fetch_add(&counters[counter], amount, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Returns the smallest bucket value which at least the given fraction of a
+ * histogram's latencies are within. A bucket's value is the largest it can
+ * hold, so it is kept between the smallest and largest latencies recorded.
+ */
+static unsigned long long percentile(struct Histogram* histogram,
+        double fraction) {
+    unsigned long long target = fraction * histogram->count + 0.5;
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target && seen) {
+            unsigned long long value = bucket_value(i);
+            if (value > histogram->max) {
+                value = histogram->max;
+            }
+            return value < histogram->min ? histogram->min : value;
+        }
+    }
+    return histogram->max;
+}
+
+/*
+ * writes the latency distribution of a phase, in the style of HdrHistogram's
+ * percentile output
+ */
+static void write_histogram(FILE* output, const char* name,
+        struct Histogram* histogram) {
+    fprintf(output, "%s: count=%llu mean=%.0fns p50=%lluns p90=%lluns "
+            "p99=%lluns p99.9=%lluns max=%lluns\n", name, histogram->count,
+            (double) histogram->total / histogram->count,
+            percentile(histogram, 0.5), percentile(histogram, 0.9),
+            percentile(histogram, 0.99), percentile(histogram, 0.999),
+            histogram->max);
+    fprintf(output, "%16s %12s %12s\n", "Value(ns)", "Percentile",
+            "TotalCount");
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        if (!histogram->counts[i]) {
+            continue;
+        }
+        seen += histogram->counts[i];
+        fprintf(output, "%16llu %12.6f %12llu\n", bucket_value(i),
+                (double) seen / histogram->count, seen);
+    }
+    fprintf(output, "\n");
+}
+
+/*
+ * writes every phase's histogram and the counters to the report
+ */
+void write_stats(void) {
+    if (!reportName) {
+        return; //statistics were never turned on
+    }
+    bool useStderr = !strcmp(reportName, "1") || 
+            !strcmp(reportName, "stderr");
+    FILE* output = useStderr ? stderr : fopen(reportName, "w");
+    if (!output) {
+        fprintf(stderr, "Unable to write statistics to %s\n", reportName);
+        return;
+    }
+
+    for (int phase = 0; phase < STAT_PHASES; phase++) {
+        if (histograms[phase].count) {
+            write_histogram(output, phaseNames[phase], &histograms[phase]);
+        }
+    }
+    for (int counter = 0; counter < STAT_COUNTERS; counter++) {
+        fprintf(output, "%s=%llu\n", counterNames[counter], 
+                counters[counter]);
+    }
+    if (!useStderr) {
+        fclose(output);
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * Counters and timers for the engine's hot paths. They are only compiled in
+ * when NOGO_STATS is defined (make STATS=1), and then only record anything
+ * when the NOGO_STATS environment variable is set, to "1" or "stderr" to
+ * report to standard error at exit, or otherwise to the name of a file to
+ * write the report to.
+ */
+
+/* the phases of a move which are timed */
+enum StatPhase {
+    STAT_GET_INPUT,
+    STAT_PLACE_STONE,
+    STAT_UPDATE_STRINGS,
+    STAT_CHECK_FOR_CAPTURES,
+    STAT_DRAW_BOARD,
+    STAT_SAVE_GAME,
+    STAT_PHASES //the number of phases
+};
+
+/* the events which are counted */
+enum StatCounter {
+    STAT_CELLS_SCANNED,
+    STAT_STRINGS_MERGED,
+    STAT_ALLOCATIONS,
+    STAT_COUNTERS //the number of counters
+};
+
+#ifdef NOGO_STATS
+#define STAT_TIMER(timer) long long timer = stat_clock()
+#define STAT_RECORD(phase, timer) stat_record(phase, timer)
+#define STAT_COUNT(counter, amount) stat_count(counter, amount)
+#else
+#define STAT_TIMER(timer)
+#define STAT_RECORD(phase, timer)
+#define STAT_COUNT(counter, amount)
+#endif
+
+long long stat_clock(void);
+void stat_record(enum StatPhase phase, long long start);
+void stat_count(enum StatCounter counter, long long amount);
+void write_stats(void);